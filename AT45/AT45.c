@@ -1,12 +1,125 @@
 #include "AT45.h"
 
+/* Transaction descriptor: everything, that is clocked under a single CS assertion */
+typedef struct AT45_Transaction_s
+{
+    uint8_t header[8]; // Opcode, address and dummy bytes
+    uint8_t headerLength;
+    const uint8_t *pDataTX; // Data segment to transmit...
+    uint8_t *pDataRX; // ...or to receive
+    uint32_t dataLength;
+    uint8_t trailer[AT45_CHECKSUM_MAX_SIZE]; // Checksum, follows the data segment direction
+    uint8_t trailerLength;
+} AT45_Transaction_t;
+
+/* Buffer Read opcodes: [buffer][dummy bytes] */
+static const uint8_t AT45_BufferReadOpcodes[2][2] = {
+    {AT45_CMD_BUFFER_1_READ_LOW_FREQUENCY, AT45_CMD_BUFFER_1_READ},
+    {AT45_CMD_BUFFER_2_READ_LOW_FREQUENCY, AT45_CMD_BUFFER_2_READ}};
+
+/* ModBus CRC16 (poly 0xA001 reflected) of every byte value */
+static const uint16_t ModBus_CRC_Table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040};
+
+/* SRAM buffer writing opcodes */
+typedef struct AT45_BufferOpcodes_s
+{
+    uint8_t transfer; // Main Memory Page to Buffer Transfer
+    uint8_t write;
+    uint8_t program; // Buffer to Main Memory Page Program without Built-In Erase
+    uint8_t programErase;
+    uint8_t programThrough; // Main Memory Page Program through Buffer without Built-In Erase, Buffer 1 only
+    uint8_t programThroughErase;
+} AT45_BufferOpcodes_t;
+
+static const AT45_BufferOpcodes_t AT45_BufferWriteOpcodes[2] = {
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_TRANSFER, AT45_CMD_BUFFER_1_WRITE,
+     AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM, AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE,
+     AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1, AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1_ERASE},
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER, AT45_CMD_BUFFER_2_WRITE,
+     AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM, AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE, 0x00,
+     AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_2_ERASE}};
+
 /* Private function prototypes */
+static void AT45_TransactionInit(AT45_Transaction_t *transaction, uint8_t opcode, uint32_t address,
+                                 uint8_t addressLength, uint8_t dummyLength);
+static void AT45_TransactionExecute(AT45_HandleTypeDef *AT45_Handle, const AT45_Transaction_t *transaction);
+static void AT45_TransferData(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint32_t size,
+                              uint32_t timeout);
 static void AT45_ReadID(AT45_HandleTypeDef *AT45_Handle);
 static void AT45_ReadStatus(AT45_HandleTypeDef *AT45_Handle);
 static ErrorStatus AT45_WaitWithTimeout(AT45_HandleTypeDef *AT45_Handle, uint32_t timeout);
 static uint16_t AT45_PageSizeCheck(AT45_HandleTypeDef *AT45_Handle);
 static ErrorStatus AT45_PageSizeConfig(AT45_HandleTypeDef *AT45_Handle, uint16_t targetPageSize);
-static uint16_t ModBus_CRC(const uint8_t *pBuffer, uint16_t bufSize);
+#ifdef AT45_USE_CLOCK_TUNING
+static void AT45_ClockTuning(AT45_HandleTypeDef *AT45_Handle);
+static ErrorStatus AT45_ClockVerify(AT45_HandleTypeDef *AT45_Handle, const uint8_t *ID);
+#endif
+static void AT45_ReadOpcodeSelect(AT45_HandleTypeDef *AT45_Handle);
+static void AT45_ReadVectorSort(AT45_ReadRequest_t *requests, uint16_t count);
+static uint16_t AT45_ReadVectorRun(AT45_HandleTypeDef *AT45_Handle, const AT45_ReadRequest_t *requests,
+                                   uint16_t count, uint16_t maxGap);
+static ErrorStatus AT45_PageProgram(AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                                    uint32_t address, bool trailingCRC, bool pageErase);
+static AT45_Status_t AT45_ProgramWait(AT45_HandleTypeDef *AT45_Handle, uint8_t bufferIndex, uint32_t page,
+                                      bool pageErase, AT45_WaitForTask_t waitForTask);
+static ErrorStatus AT45_ReadPrepare(AT45_HandleTypeDef *AT45_Handle, AT45_Transaction_t *transaction,
+                                    int8_t bufferIndex, uint32_t address);
+static void AT45_FrameSeal(const AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                           uint8_t *trailer);
+static AT45_Status_t AT45_FrameCheck(const AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                                     const uint8_t *trailer, bool trailingCRC);
+static int8_t AT45_BufferFind(const AT45_HandleTypeDef *AT45_Handle, uint32_t page);
+static void AT45_BufferInvalidate(AT45_HandleTypeDef *AT45_Handle, uint32_t firstPage, uint32_t numberOfPages);
+static AT45_Status_t AT45_BufferCompare(AT45_HandleTypeDef *AT45_Handle, uint8_t bufferIndex, uint32_t page);
+static void AT45_OperationFinish(AT45_HandleTypeDef *AT45_Handle);
+#ifdef AT45_USE_PREFETCH
+static const uint8_t *AT45_PrefetchLookup(AT45_HandleTypeDef *AT45_Handle, uint32_t address);
+static void AT45_PrefetchStart(AT45_HandleTypeDef *AT45_Handle);
+static ErrorStatus AT45_PrefetchCollect(AT45_HandleTypeDef *AT45_Handle, bool wait);
+static void AT45_PrefetchInvalidate(AT45_HandleTypeDef *AT45_Handle);
+#endif
+#ifdef AT45_USE_CACHE
+static AT45_CacheSlot_t *AT45_CacheLookup(AT45_HandleTypeDef *AT45_Handle, int8_t bufferIndex, uint32_t page);
+static void AT45_CacheInvalidate(AT45_HandleTypeDef *AT45_Handle, uint32_t firstPage, uint32_t numberOfPages);
+#endif
+static uint32_t ModBus_CRC(const uint8_t *pBuffer, uint16_t bufSize);
+static uint32_t ModBus_CRC_Bitwise(const uint8_t *pBuffer, uint16_t bufSize);
+
+/* Predefined checksums */
+const AT45_Checksum_t AT45_ModBusChecksum = {.size = sizeof(uint16_t), .compute = ModBus_CRC};
+const AT45_Checksum_t AT45_ModBusBitwiseChecksum = {.size = sizeof(uint16_t), .compute = ModBus_CRC_Bitwise};
 
 AT45_Status_t AT45_Init(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspix, GPIO_TypeDef *CS_Port,
                         uint16_t CS_Pin)
@@ -21,13 +134,35 @@ AT45_Status_t AT45_Init(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspi
     if (CS_Pin == 0x0000)
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
 
-    AT45_Delay(100);
+    /* Transport */
+    if (AT45_Handle->ops == NULL)
+        AT45_Handle->ops = &AT45_PollingOps;
+    if (AT45_Handle->checksum == NULL)
+        AT45_Handle->checksum = &AT45_ModBusChecksum;
+    if (AT45_Handle->checksum->size > AT45_CHECKSUM_MAX_SIZE)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    AT45_Handle->ops->delay(100);
 
     /* SPI device specific info retrieve */
     AT45_Handle->hspix = hspix;
     AT45_Handle->CS_Port = CS_Port;
     AT45_Handle->CS_Pin = CS_Pin;
+    AT45_Handle->baudRatePrescaler = AT45_SPI_GetPrescaler(hspix);
+    AT45_Handle->bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle->bufferPage[1] = AT45_NO_PAGE;
+    AT45_Handle->bufferBusy = 0;
+    AT45_Handle->writeBuffer = 0;
     AT45_Handle->status = AT45_STATUS_RESET;
+    memset(&AT45_Handle->operation, 0, sizeof(AT45_Handle->operation));
+    AT45_Handle->operation.result = AT45_STATUS_READY;
+    AT45_Handle->operationCount = 0;
+#ifdef AT45_USE_PREFETCH
+    memset(&AT45_Handle->prefetch, 0, sizeof(AT45_Handle->prefetch));
+#endif
+#ifdef AT45_USE_CACHE
+    memset(&AT45_Handle->cache, 0, sizeof(AT45_Handle->cache));
+#endif
 
     /* Check for SPI1-3 match */
     if ((AT45_Handle->hspix->Instance != SPI1) && (AT45_Handle->hspix->Instance != SPI2) &&
@@ -60,7 +195,12 @@ AT45_Status_t AT45_Init(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspi
             return AT45_Handle->status = AT45_STATUS_ERROR_INITIALIZATION;
     }
 
-    AT45_Delay(10);
+#ifdef AT45_USE_CLOCK_TUNING
+    AT45_ClockTuning(AT45_Handle);
+#endif
+    AT45_ReadOpcodeSelect(AT45_Handle);
+
+    AT45_Handle->ops->delay(10);
 
     return AT45_Handle->status = AT45_STATUS_READY;
 }
@@ -70,158 +210,321 @@ AT45_Status_t AT45_Write(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, ui
 {
     AT45_Handle->status = AT45_STATUS_BUSY_WRITE;
     uint16_t frameLength = dataLength;
-    uint16_t CRC16 = 0x0000;
 
     /* Argument guards */
     if ((dataLength == 0) || (buf == NULL))
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
     if (trailingCRC)
-        frameLength += sizeof(CRC16);
-    if (frameLength > AT45_PAGE_SIZE)
-        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-    if ((address % AT45_PAGE_SIZE) != 0)
+        frameLength += AT45_Handle->checksum->size;
+    if (((address % AT45_PAGE_SIZE) + frameLength) > AT45_PAGE_SIZE)
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-    if (address > (AT45_PAGE_SIZE * (AT45_Handle->numberOfPages - 1)))
+    if (address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
 
-    /* Checksum calculate */
-    if (trailingCRC)
-        CRC16 = ModBus_CRC(buf, dataLength);
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchInvalidate(AT45_Handle);
+#endif
+#ifdef AT45_USE_CACHE
+    AT45_CacheInvalidate(AT45_Handle, address / AT45_PAGE_SIZE, 1);
+#endif
 
-    if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+    if (AT45_PageProgram(AT45_Handle, buf, dataLength, address, trailingCRC, pageErase) != SUCCESS)
         return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
 
-    /* Buffer write */
-    /* Command */
-    AT45_Handle->CMD[0] = AT45_CMD_BUFFER_1_WRITE;
-    CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
-    /* BFA8-BFA0 - Address of the first byte in the SRAM buffer to be written */
-    /* Fixed zero position */
-    ADDRESS_BYTES_SWAP(AT45_Handle, 0);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                      AT45_TX_TIMEOUT);
-
-    /* AT45 SRAM buffer filling by user data */
-    /* Data */
-    AT45_SPI_Transmit(AT45_Handle->hspix, (uint8_t *) buf, dataLength, AT45_TX_TIMEOUT);
+    return AT45_Handle->status =
+               AT45_ProgramWait(AT45_Handle, AT45_Handle->writeBuffer ^ 1, address / AT45_PAGE_SIZE, pageErase,
+                                waitForTask);
+}
 
-    /* Checksum */
-    if (trailingCRC)
-        AT45_SPI_Transmit(AT45_Handle->hspix, (uint8_t *) &CRC16, sizeof(CRC16), AT45_TX_TIMEOUT);
-    CS_HIGH(AT45_Handle);
+AT45_Status_t AT45_WriteStream(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, uint32_t dataLength,
+                               uint32_t address, bool trailingCRC, bool pageErase, AT45_WaitForTask_t waitForTask)
+{
+    AT45_Handle->status = AT45_STATUS_BUSY_WRITE;
+    AT45_Status_t status;
+    uint16_t trailerLength = trailingCRC ? AT45_Handle->checksum->size : 0;
+    uint16_t frameLength;
+    uint32_t firstPage = address / AT45_PAGE_SIZE;
+    uint32_t lastPage = firstPage;
 
-    /* Page program */
-    /* Command */
-    if (pageErase)
-        AT45_Handle->CMD[0] = AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE;
-    else
-        AT45_Handle->CMD[0] = AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM;
-    CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
+    /* Argument guards */
+    if ((dataLength == 0) || (buf == NULL))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (((address % AT45_PAGE_SIZE) + trailerLength) >= AT45_PAGE_SIZE)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT; // No room for the leading frame
+
+    /* Address guards */
+    frameLength = AT45_PAGE_SIZE - (address % AT45_PAGE_SIZE) - trailerLength;
+    if (dataLength > frameLength)
+        lastPage += (dataLength - frameLength + (AT45_PAGE_SIZE - trailerLength) - 1) / (AT45_PAGE_SIZE - trailerLength);
+    if (lastPage >= AT45_Handle->numberOfPages)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
 
-    /* A20-A9 - 12 page address bits that specify the page in the main memory to be written */
-    ADDRESS_BYTES_SWAP(AT45_Handle, address);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                      AT45_TX_TIMEOUT);
-    CS_HIGH(AT45_Handle);
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchInvalidate(AT45_Handle);
+#endif
+#ifdef AT45_USE_CACHE
+    AT45_CacheInvalidate(AT45_Handle, firstPage, lastPage - firstPage + 1);
+#endif
 
-    /* Wait options */
-    if (waitForTask == AT45_WAIT_DELAY)
-    {
-        if (pageErase)
-            AT45_Delay(AT45_PAGE_ERASE_PROGRAMMING_TIME);
-        else
-            AT45_Delay(AT45_PAGE_PROGRAMMING_TIME);
-    }
-    else if (waitForTask == AT45_WAIT_BUSY)
+    /* One frame per page: the leading one starts at the address, the following ones at the page start */
+    while (1)
     {
-        if (pageErase)
+        frameLength = AT45_PAGE_SIZE - (address % AT45_PAGE_SIZE) - trailerLength;
+        if (frameLength > dataLength)
+            frameLength = (uint16_t) dataLength;
+        if (AT45_PageProgram(AT45_Handle, buf, frameLength, address, trailingCRC, pageErase) != SUCCESS)
+            return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+
+        /* The previous page was completed before this one started, the last wait holds its EPE */
+        if ((waitForTask == AT45_WAIT_BUSY) && ((address / AT45_PAGE_SIZE) != firstPage) &&
+            READ_BIT(AT45_Handle->statusRegister[1], 1u << 5))
         {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_PAGE_ERASE_PROGRAMMING_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+            AT45_BufferInvalidate(AT45_Handle, (address / AT45_PAGE_SIZE) - 1, 1);
+            return AT45_Handle->status = AT45_STATUS_ERROR_PROGRAM;
         }
-        else
+        buf += frameLength;
+        dataLength -= frameLength;
+        if (dataLength == 0)
+            break;
+
+        /* Every page is compared before its buffer is refilled */
+        if (waitForTask == AT45_WAIT_VERIFY)
         {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_PAGE_PROGRAMMING_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+            status = AT45_ProgramWait(AT45_Handle, AT45_Handle->writeBuffer ^ 1, address / AT45_PAGE_SIZE, pageErase,
+                                      waitForTask);
+            if (status != AT45_STATUS_READY)
+                return AT45_Handle->status = status;
         }
+        address = ((address / AT45_PAGE_SIZE) + 1) * AT45_PAGE_SIZE;
     }
 
-    return AT45_Handle->status = AT45_STATUS_READY;
+    return AT45_Handle->status = AT45_ProgramWait(AT45_Handle, AT45_Handle->writeBuffer ^ 1,
+                                                  address / AT45_PAGE_SIZE, pageErase, waitForTask);
+}
+
+AT45_Status_t AT45_Update(AT45_HandleTypeDef *AT45_Handle, uint32_t address, uint16_t offset, const uint8_t *data,
+                          uint16_t dataLength, AT45_WaitForTask_t waitForTask)
+{
+    /* Argument guards */
+    if ((address % AT45_PAGE_SIZE) != 0)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (offset >= AT45_PAGE_SIZE)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    /* The merge with the page contents is done on chip by the buffer program with built-in erase */
+    return AT45_Write(AT45_Handle, data, dataLength, address + offset, false, true, waitForTask);
+}
+
+AT45_Status_t AT45_WriteAsync(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, uint16_t dataLength,
+                              uint32_t address, bool trailingCRC, bool pageErase, uint32_t *token)
+{
+    AT45_Handle->status = AT45_STATUS_BUSY_WRITE;
+    AT45_Operation_t *operation = &AT45_Handle->operation;
+    uint32_t previousToken;
+    AT45_Status_t previousResult;
+    uint16_t frameLength = dataLength;
+
+    /* Argument guards */
+    if ((dataLength == 0) || (buf == NULL))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (trailingCRC)
+        frameLength += AT45_Handle->checksum->size;
+    if (((address % AT45_PAGE_SIZE) + frameLength) > AT45_PAGE_SIZE)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchInvalidate(AT45_Handle);
+#endif
+#ifdef AT45_USE_CACHE
+    AT45_CacheInvalidate(AT45_Handle, address / AT45_PAGE_SIZE, 1);
+#endif
+
+    /* The page program waits for the device, so the previous operation gets its result */
+    if (AT45_PageProgram(AT45_Handle, buf, dataLength, address, trailingCRC, pageErase) != SUCCESS)
+        return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+    previousToken = operation->token;
+    previousResult = operation->result;
+
+    /* Token 0 is reserved for no operation */
+    if (++AT45_Handle->operationCount == 0)
+        AT45_Handle->operationCount = 1;
+    operation->token = AT45_Handle->operationCount;
+    operation->page = address / AT45_PAGE_SIZE;
+    operation->tickStart = AT45_Handle->ops->tick();
+    operation->duration = pageErase ? AT45_PAGE_ERASE_PROGRAMMING_TIME : AT45_PAGE_PROGRAMMING_TIME;
+    operation->result = AT45_STATUS_BUSY_WRITE;
+    if (token != NULL)
+        *token = operation->token;
+
+    /* The new operation is recorded first, so the callback may start the next one */
+    if (previousToken != 0)
+        AT45_WriteCpltCallback(AT45_Handle, previousToken, previousResult);
+
+    return AT45_Handle->status = AT45_STATUS_BUSY_WRITE;
 }
 
 AT45_Status_t AT45_Read(AT45_HandleTypeDef *AT45_Handle, uint8_t *buf, uint16_t dataLength, uint32_t address,
                         bool trailingCRC)
 {
     AT45_Handle->status = AT45_STATUS_BUSY_READ;
+    AT45_Transaction_t transaction;
     uint16_t frameLength = dataLength;
-    uint16_t CRC16 = 0x0000;
+    int8_t bufferIndex;
+#if defined(AT45_USE_PREFETCH) || defined(AT45_USE_CACHE)
+    const uint8_t *frame = NULL;
+#endif
+#ifdef AT45_USE_CACHE
+    AT45_CacheSlot_t *slot;
+#endif
 
     /* Argument guards */
     if ((dataLength == 0) || (buf == NULL))
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
     if (trailingCRC)
-        frameLength += sizeof(CRC16);
-    if (frameLength > AT45_PAGE_SIZE)
+        frameLength += AT45_Handle->checksum->size;
+    if (((address % AT45_PAGE_SIZE) + frameLength) > AT45_PAGE_SIZE)
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-    if ((address % AT45_PAGE_SIZE) != 0)
+    if (address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    bufferIndex = AT45_BufferFind(AT45_Handle, address / AT45_PAGE_SIZE);
+
+#ifdef AT45_USE_CACHE
+    /* Repeatedly read pages are served from RAM, the whole page is read on miss */
+    if (AT45_Handle->cache.count != 0)
+    {
+        slot = AT45_CacheLookup(AT45_Handle, bufferIndex, address / AT45_PAGE_SIZE);
+        if (slot != NULL)
+            frame = &slot->data[address % AT45_PAGE_SIZE];
+    }
+#endif
+#ifdef AT45_USE_PREFETCH
+    /* Sequential access is served from the page buffers */
+    if ((frame == NULL) && (bufferIndex < 0) && (AT45_Handle->prefetch.depth != 0))
+        frame = AT45_PrefetchLookup(AT45_Handle, address);
+#endif
+#if defined(AT45_USE_PREFETCH) || defined(AT45_USE_CACHE)
+    if (frame != NULL)
+    {
+        memcpy(buf, frame, dataLength);
+        return AT45_Handle->status = AT45_FrameCheck(AT45_Handle, buf, dataLength, &frame[dataLength], trailingCRC);
+    }
+#endif
+
+    /* The frame does not cross the page boundary, so the continuous read stops within the page */
+    /* Data is received directly to the destination buffer, CRC - to the transaction trailer */
+    if (AT45_ReadPrepare(AT45_Handle, &transaction, bufferIndex, address) != SUCCESS)
+        return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+    transaction.pDataRX = buf;
+    transaction.dataLength = dataLength;
+    if (trailingCRC)
+        transaction.trailerLength = AT45_Handle->checksum->size;
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+
+    return AT45_Handle->status = AT45_FrameCheck(AT45_Handle, buf, dataLength, transaction.trailer, trailingCRC);
+}
+
+AT45_Status_t AT45_ReadStream(AT45_HandleTypeDef *AT45_Handle, uint8_t *buf, uint32_t dataLength, uint32_t address)
+{
+    AT45_Handle->status = AT45_STATUS_BUSY_READ;
+    AT45_Transaction_t transaction;
+
+    /* Argument guards */
+    if ((dataLength == 0) || (buf == NULL))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-    if (address > (AT45_PAGE_SIZE * (AT45_Handle->numberOfPages - 1)))
+    if (dataLength > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - address))
         return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
 
+#ifdef AT45_USE_PREFETCH
+    /* Buffered pages stay valid, only the bus is needed */
+    AT45_PrefetchCollect(AT45_Handle, true);
+#endif
+
     if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
         return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
 
-    /* Frame buffer memory allocation */
-    uint8_t *frameBuf = malloc(sizeof(*frameBuf) * frameLength);
-    if (frameBuf == NULL)
-        return AT45_Handle->status = AT45_STATUS_ERROR_MEM_MANAGE;
+    /* A20-A0 - byte address to start from, dummy bytes of the selected read opcode */
+    /* The device turns the pages itself while CS is low */
+    AT45_TransactionInit(&transaction, AT45_Handle->readOpcode, address, 3, AT45_Handle->readDummyLength);
+    transaction.pDataRX = buf;
+    transaction.dataLength = dataLength;
+    AT45_TransactionExecute(AT45_Handle, &transaction);
 
-    /* Command */
-    AT45_Handle->CMD[0] = AT45_CMD_MAIN_MEMORY_PAGE_READ;
-    CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
-    /* A20-A9 - 12 page address bits that specify the page in the main memory to be read */
-    ADDRESS_BYTES_SWAP(AT45_Handle, address);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                      AT45_TX_TIMEOUT);
-
-    /* 4 dummy bytes */
-    AT45_Handle->CMD[0] = 0;
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
-    /* Data receive */
-    AT45_SPI_Receive(AT45_Handle->hspix, frameBuf, frameLength, AT45_RX_TIMEOUT);
-    CS_HIGH(AT45_Handle);
+    return AT45_Handle->status = AT45_STATUS_READY;
+}
 
-    /* Checksum compare */
-    if (trailingCRC)
+AT45_Status_t AT45_ReadVector(AT45_HandleTypeDef *AT45_Handle, AT45_ReadRequest_t *requests, uint16_t count,
+                              uint16_t maxGap)
+{
+    AT45_Handle->status = AT45_STATUS_BUSY_READ;
+    uint16_t i;
+
+    /* Argument guards */
+    if ((requests == NULL) || (count == 0))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    for (i = 0; i < count; i++)
     {
-        CRC16 = ModBus_CRC(frameBuf, dataLength);
-        if (memcmp(&frameBuf[dataLength], &CRC16, sizeof(CRC16)) != 0)
-        {
-            free(frameBuf);
-            return AT45_Handle->status = AT45_STATUS_ERROR_CHECKSUM;
-        }
+        if ((requests[i].dataLength == 0) || (requests[i].buf == NULL))
+            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+        if (requests[i].address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
+            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+        if (requests[i].dataLength > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - requests[i].address))
+            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
     }
 
-    /* Copy received data without checksum to the destination buffer */
-    memcpy(buf, frameBuf, dataLength);
-    free(frameBuf);
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchCollect(AT45_Handle, true);
+#endif
+
+    if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+        return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+
+    /* Every run of close fragments is a single continuous read */
+    AT45_ReadVectorSort(requests, count);
+    for (i = 0; i < count;)
+        i += AT45_ReadVectorRun(AT45_Handle, &requests[i], count - i, maxGap);
 
     return AT45_Handle->status = AT45_STATUS_READY;
 }
 
+AT45_Status_t AT45_Verify(AT45_HandleTypeDef *AT45_Handle, uint32_t address)
+{
+    AT45_Handle->status = AT45_STATUS_BUSY_READ;
+    int8_t bufferIndex;
+
+    /* Address guards */
+    if (address >= (AT45_PAGE_SIZE * AT45_Handle->numberOfPages))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    /* Nothing to compare with unless the page was written through a buffer */
+    bufferIndex = AT45_BufferFind(AT45_Handle, address / AT45_PAGE_SIZE);
+    if (bufferIndex < 0)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchCollect(AT45_Handle, true);
+#endif
+    if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+        return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+
+    return AT45_Handle->status = AT45_BufferCompare(AT45_Handle, bufferIndex, address / AT45_PAGE_SIZE);
+}
+
 AT45_Status_t AT45_Erase(AT45_HandleTypeDef *AT45_Handle, AT45_EraseInstruction_t eraseInstruction, uint32_t address,
                          AT45_WaitForTask_t waitForTask)
 {
     AT45_Handle->status = AT45_STATUS_BUSY_ERASE;
+    AT45_Transaction_t transaction;
+    uint32_t eraseSize;
+    uint32_t eraseTime;
+
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchInvalidate(AT45_Handle);
+#endif
 
     if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
         return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
@@ -229,162 +532,286 @@ AT45_Status_t AT45_Erase(AT45_HandleTypeDef *AT45_Handle, AT45_EraseInstruction_
     switch (eraseInstruction)
     {
     case AT45_PAGE_ERASE:
-        if ((address % AT45_PAGE_SIZE) != 0)
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-        if (address > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - AT45_PAGE_SIZE))
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-
-        /* Command */
-        AT45_Handle->CMD[0] = AT45_CMD_PAGE_ERASE;
-        CS_LOW(AT45_Handle);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
         /* A20-A9 - 12 page address bits that specify the page in the main memory to be erased */
-        ADDRESS_BYTES_SWAP(AT45_Handle, address);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                          AT45_TX_TIMEOUT);
-        CS_HIGH(AT45_Handle);
-
-        /* Wait options */
-        if (waitForTask == AT45_WAIT_DELAY)
-            AT45_Delay(AT45_PAGE_ERASE_TIME);
-        else if (waitForTask == AT45_WAIT_BUSY)
-        {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_PAGE_ERASE_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
-        }
+        AT45_TransactionInit(&transaction, AT45_CMD_PAGE_ERASE, address, 3, 0);
+        eraseSize = AT45_PAGE_SIZE;
+        eraseTime = AT45_PAGE_ERASE_TIME;
         break;
 
     case AT45_BLOCK_ERASE:
-        if ((address % AT45_BLOCK_SIZE) != 0)
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-        if (address > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - AT45_BLOCK_SIZE))
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-
-        /* Command */
-        AT45_Handle->CMD[0] = AT45_CMD_BLOCK_ERASE;
-        CS_LOW(AT45_Handle);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
         /* A20-A12 - 9 block address bits that specify the block in the main memory to be erased */
-        ADDRESS_BYTES_SWAP(AT45_Handle, address);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                          AT45_TX_TIMEOUT);
-        CS_HIGH(AT45_Handle);
-
-        /* Wait options */
-        if (waitForTask == AT45_WAIT_DELAY)
-            AT45_Delay(AT45_BLOCK_ERASE_TIME);
-        else if (waitForTask == AT45_WAIT_BUSY)
-        {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_BLOCK_ERASE_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
-        }
+        AT45_TransactionInit(&transaction, AT45_CMD_BLOCK_ERASE, address, 3, 0);
+        eraseSize = AT45_BLOCK_SIZE;
+        eraseTime = AT45_BLOCK_ERASE_TIME;
         break;
 
     case AT45_SECTOR_ERASE:
-        if ((address % AT45_SECTOR_SIZE) != 0)
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-        if (address > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - AT45_SECTOR_SIZE))
-            return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
-
-        /* Command */
-        AT45_Handle->CMD[0] = AT45_CMD_SECTOR_ERASE;
-        CS_LOW(AT45_Handle);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-
         /* A20-A12 - 9 sector address bits that specify the sector in the main memory to be erased */
-        ADDRESS_BYTES_SWAP(AT45_Handle, address);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->addressBytes, sizeof(AT45_Handle->addressBytes),
-                          AT45_TX_TIMEOUT);
-        CS_HIGH(AT45_Handle);
-
-        /* Wait options */
-        if (waitForTask == AT45_WAIT_DELAY)
-            AT45_Delay(AT45_SECTOR_ERASE_TIME);
-        else if (waitForTask == AT45_WAIT_BUSY)
-        {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_SECTOR_ERASE_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
-        }
+        AT45_TransactionInit(&transaction, AT45_CMD_SECTOR_ERASE, address, 3, 0);
+        eraseSize = AT45_SECTOR_SIZE;
+        eraseTime = AT45_SECTOR_ERASE_TIME;
         break;
 
     case AT45_CHIP_ERASE:
         if (address != 0)
             return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
 
-        /* Command */
-        AT45_Handle->CMD[0] = AT45_CMD_CHIP_ERASE_0;
-        AT45_Handle->CMD[1] = AT45_CMD_CHIP_ERASE_1;
-        AT45_Handle->CMD[2] = AT45_CMD_CHIP_ERASE_2;
-        AT45_Handle->CMD[3] = AT45_CMD_CHIP_ERASE_3;
-        CS_LOW(AT45_Handle);
-        AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD), AT45_TX_TIMEOUT);
-        CS_HIGH(AT45_Handle);
-
-        /* Wait options */
-        if (waitForTask == AT45_WAIT_DELAY)
-            AT45_Delay(AT45_CHIP_ERASE_TIME);
-        else if (waitForTask == AT45_WAIT_BUSY)
-        {
-            if (AT45_WaitWithTimeout(AT45_Handle, AT45_CHIP_ERASE_TIME) != SUCCESS)
-                return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
-        }
+        /* 4-byte command sequence */
+        AT45_TransactionInit(&transaction, AT45_CMD_CHIP_ERASE_0, 0, 0, 0);
+        transaction.header[1] = AT45_CMD_CHIP_ERASE_1;
+        transaction.header[2] = AT45_CMD_CHIP_ERASE_2;
+        transaction.header[3] = AT45_CMD_CHIP_ERASE_3;
+        transaction.headerLength = 4;
+        eraseSize = AT45_PAGE_SIZE * AT45_Handle->numberOfPages;
+        eraseTime = AT45_CHIP_ERASE_TIME;
         break;
 
     default:
         return AT45_Handle->status = AT45_STATUS_ERROR_INSTRUCTION;
     }
 
+    /* Address guards */
+    if ((address % eraseSize) != 0)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (address > ((AT45_PAGE_SIZE * AT45_Handle->numberOfPages) - eraseSize))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+    AT45_BufferInvalidate(AT45_Handle, address / AT45_PAGE_SIZE, eraseSize / AT45_PAGE_SIZE);
+#ifdef AT45_USE_CACHE
+    AT45_CacheInvalidate(AT45_Handle, address / AT45_PAGE_SIZE, eraseSize / AT45_PAGE_SIZE);
+#endif
+
+    /* Wait options */
+    if (waitForTask == AT45_WAIT_DELAY)
+        AT45_Handle->ops->delay(eraseTime);
+    else if ((waitForTask == AT45_WAIT_BUSY) || (waitForTask == AT45_WAIT_VERIFY))
+    {
+        if (AT45_WaitWithTimeout(AT45_Handle, eraseTime) != SUCCESS)
+            return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+        /* EPE: the erase failed */
+        if (READ_BIT(AT45_Handle->statusRegister[1], 1u << 5))
+            return AT45_Handle->status = AT45_STATUS_ERROR_PROGRAM;
+    }
+
     return AT45_Handle->status = AT45_STATUS_READY;
 }
 
 bool AT45_Busy(AT45_HandleTypeDef *AT45_Handle)
 {
+#ifdef AT45_USE_PREFETCH
+    AT45_PrefetchCollect(AT45_Handle, true);
+#endif
     AT45_ReadStatus(AT45_Handle);
+    if (!READ_BIT(AT45_Handle->statusRegister[0], 1u << 7))
+        return true;
+
+    AT45_OperationFinish(AT45_Handle);
 
-    return !READ_BIT(AT45_Handle->statusRegister[0], 1u << 7);
+    return false;
 }
 
+AT45_Status_t AT45_Poll(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Operation_t *operation = &AT45_Handle->operation;
+    uint32_t token;
+
+    if (operation->result == AT45_STATUS_BUSY_WRITE)
+    {
+        /* Ready, or overdue by the response timeout */
+        if (!AT45_Busy(AT45_Handle))
+            AT45_Handle->bufferBusy = 0;
+        else if ((AT45_Handle->ops->tick() - operation->tickStart) > (operation->duration + AT45_RESPONSE_TIMEOUT))
+        {
+            operation->result = AT45_STATUS_ERROR_TIMEOUT;
+            AT45_BufferInvalidate(AT45_Handle, operation->page, 1);
+        }
+    }
+
+    /* Delivered once, the callback may start the next operation */
+    token = operation->token;
+    if ((token != 0) && (operation->result != AT45_STATUS_BUSY_WRITE))
+    {
+        operation->token = 0;
+        AT45_WriteCpltCallback(AT45_Handle, token, operation->result);
+        return AT45_Handle->status = (operation->token != 0) ? AT45_STATUS_BUSY_WRITE : operation->result;
+    }
+
+    return AT45_Handle->status = operation->result;
+}
+
+__weak void AT45_WriteCpltCallback(AT45_HandleTypeDef *AT45_Handle, uint32_t token, AT45_Status_t result)
+{
+    /* Prevent unused argument(s) compilation warning */
+    (void) AT45_Handle;
+    (void) token;
+    (void) result;
+}
+
+#ifdef AT45_USE_PREFETCH
+AT45_Status_t AT45_PrefetchConfig(AT45_HandleTypeDef *AT45_Handle, uint8_t *memory, uint8_t depth)
+{
+    AT45_Prefetch_t *prefetch = &AT45_Handle->prefetch;
+
+    /* Argument guards */
+    if ((depth != 0) && (memory == NULL))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+    if (depth == 1)
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT; // Nothing to read ahead to
+
+    if (prefetch->depth != 0)
+        AT45_PrefetchInvalidate(AT45_Handle);
+
+    prefetch->memory = memory;
+    prefetch->depth = depth;
+    prefetch->head = 0;
+    prefetch->count = 0;
+    prefetch->inFlight = false;
+    prefetch->nextPage = AT45_NO_PAGE;
+    prefetch->hits = 0;
+    prefetch->misses = 0;
+
+    return AT45_Handle->status = AT45_STATUS_READY;
+}
+
+AT45_Status_t AT45_PrefetchPoll(AT45_HandleTypeDef *AT45_Handle)
+{
+    if (AT45_Handle->prefetch.depth == 0)
+        return AT45_Handle->status;
+
+    if (AT45_PrefetchCollect(AT45_Handle, false) != SUCCESS)
+        return AT45_Handle->status = AT45_STATUS_ERROR_TIMEOUT;
+    if (AT45_Handle->prefetch.count != 0)
+        AT45_PrefetchStart(AT45_Handle);
+
+    return AT45_Handle->status = AT45_STATUS_READY;
+}
+#endif
+
+#ifdef AT45_USE_CACHE
+AT45_Status_t AT45_CacheConfig(AT45_HandleTypeDef *AT45_Handle, AT45_CacheSlot_t *slots, uint8_t count)
+{
+    AT45_Cache_t *cache = &AT45_Handle->cache;
+    uint8_t i;
+
+    /* Argument guards */
+    if ((count != 0) && (slots == NULL))
+        return AT45_Handle->status = AT45_STATUS_ERROR_ARGUMENT;
+
+    for (i = 0; i < count; i++)
+        slots[i].page = AT45_NO_PAGE;
+    cache->slots = slots;
+    cache->count = count;
+    cache->useCount = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+
+    return AT45_Handle->status = AT45_STATUS_READY;
+}
+#endif
+
 /**
  * @section Private functions
  */
-static void AT45_ReadID(AT45_HandleTypeDef *AT45_Handle)
+static void AT45_TransactionInit(AT45_Transaction_t *transaction, uint8_t opcode, uint32_t address,
+                                 uint8_t addressLength, uint8_t dummyLength)
+{
+    uint8_t i;
+
+    transaction->header[0] = opcode;
+    transaction->headerLength = 1;
+
+    /* Address bytes, MSB first */
+    for (i = addressLength; i > 0; i--)
+        transaction->header[transaction->headerLength++] = (uint8_t) (address >> (8 * (i - 1)));
+
+    /* Dummy bytes */
+    for (i = 0; i < dummyLength; i++)
+        transaction->header[transaction->headerLength++] = 0x00;
+
+    transaction->pDataTX = NULL;
+    transaction->pDataRX = NULL;
+    transaction->dataLength = 0;
+    transaction->trailerLength = 0;
+}
+
+static void AT45_TransactionExecute(AT45_HandleTypeDef *AT45_Handle, const AT45_Transaction_t *transaction)
 {
-    AT45_Handle->CMD[0] = AT45_CMD_MANUFACTURER_DEVICE_ID_READ;
+    const AT45_Ops_t *ops = AT45_Handle->ops;
+
     CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-    AT45_SPI_Receive(AT45_Handle->hspix, AT45_Handle->ID, sizeof(AT45_Handle->ID), AT45_RX_TIMEOUT);
+    ops->transfer(AT45_Handle, transaction->header, NULL, transaction->headerLength, AT45_TX_TIMEOUT);
+    if ((transaction->pDataTX != NULL) && (transaction->dataLength != 0))
+    {
+        AT45_TransferData(AT45_Handle, transaction->pDataTX, NULL, transaction->dataLength, AT45_TX_TIMEOUT);
+        if (transaction->trailerLength != 0)
+            ops->transfer(AT45_Handle, transaction->trailer, NULL, transaction->trailerLength, AT45_TX_TIMEOUT);
+    }
+    else if ((transaction->pDataRX != NULL) && (transaction->dataLength != 0))
+    {
+        AT45_TransferData(AT45_Handle, NULL, transaction->pDataRX, transaction->dataLength, AT45_RX_TIMEOUT);
+        if (transaction->trailerLength != 0)
+            ops->transfer(AT45_Handle, NULL, (uint8_t *) transaction->trailer, transaction->trailerLength,
+                          AT45_RX_TIMEOUT);
+    }
     CS_HIGH(AT45_Handle);
 }
 
+static void AT45_TransferData(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint32_t size,
+                              uint32_t timeout)
+{
+    uint32_t offset;
+    uint16_t chunk;
+
+    /* Chunks keep every SPI call within its timeout at the slowest clock */
+    for (offset = 0; offset < size; offset += chunk)
+    {
+        chunk = ((size - offset) > AT45_TRANSFER_CHUNK_SIZE) ? AT45_TRANSFER_CHUNK_SIZE : (uint16_t) (size - offset);
+        AT45_Handle->ops->transfer(AT45_Handle, (pTX != NULL) ? &pTX[offset] : NULL,
+                                   (pRX != NULL) ? &pRX[offset] : NULL, chunk, timeout);
+    }
+}
+
+static void AT45_ReadID(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Transaction_t transaction;
+
+    AT45_TransactionInit(&transaction, AT45_CMD_MANUFACTURER_DEVICE_ID_READ, 0, 0, 0);
+    transaction.pDataRX = AT45_Handle->ID;
+    transaction.dataLength = sizeof(AT45_Handle->ID);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+}
+
 static void AT45_ReadStatus(AT45_HandleTypeDef *AT45_Handle)
 {
-    AT45_Handle->CMD[0] = AT45_CMD_STATUS_REGISTER_READ;
-    CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
-    AT45_SPI_Receive(AT45_Handle->hspix, AT45_Handle->statusRegister, sizeof(AT45_Handle->statusRegister),
-                     AT45_RX_TIMEOUT);
-    CS_HIGH(AT45_Handle);
+    AT45_Transaction_t transaction;
+
+    AT45_TransactionInit(&transaction, AT45_CMD_STATUS_REGISTER_READ, 0, 0, 0);
+    transaction.pDataRX = AT45_Handle->statusRegister;
+    transaction.dataLength = sizeof(AT45_Handle->statusRegister);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
 }
 
 static ErrorStatus AT45_WaitWithTimeout(AT45_HandleTypeDef *AT45_Handle, uint32_t timeout)
 {
-    uint32_t tickStart = uwTick;
+    uint32_t tickStart = AT45_Handle->ops->tick();
+    uint8_t opcode = AT45_CMD_STATUS_REGISTER_READ;
 
-    /* Command */
-    AT45_Handle->CMD[0] = AT45_CMD_STATUS_REGISTER_READ;
+    /* Command, then the status register is output continuously while CS stays low */
     CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD[0]), AT45_TX_TIMEOUT);
+    AT45_Handle->ops->transfer(AT45_Handle, &opcode, NULL, sizeof(opcode), AT45_TX_TIMEOUT);
 
-    while ((uwTick - tickStart) < timeout)
+    while ((AT45_Handle->ops->tick() - tickStart) < timeout)
     {
         /* Get busy bit state */
-        AT45_SPI_Receive(AT45_Handle->hspix, AT45_Handle->statusRegister, sizeof(AT45_Handle->statusRegister),
-                         AT45_RX_TIMEOUT);
+        AT45_Handle->ops->transfer(AT45_Handle, NULL, AT45_Handle->statusRegister,
+                                   sizeof(AT45_Handle->statusRegister), AT45_RX_TIMEOUT);
         if (READ_BIT(AT45_Handle->statusRegister[0], 1u << 7))
         {
             CS_HIGH(AT45_Handle);
+            AT45_Handle->bufferBusy = 0;
+            AT45_OperationFinish(AT45_Handle);
             return SUCCESS;
         }
     }
@@ -402,27 +829,28 @@ static uint16_t AT45_PageSizeCheck(AT45_HandleTypeDef *AT45_Handle)
 
 static ErrorStatus AT45_PageSizeConfig(AT45_HandleTypeDef *AT45_Handle, uint16_t targetPageSize)
 {
+    AT45_Transaction_t transaction;
+
     if (targetPageSize == 512)
     {
-        AT45_Handle->CMD[0] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_0;
-        AT45_Handle->CMD[1] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_1;
-        AT45_Handle->CMD[2] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_2;
-        AT45_Handle->CMD[3] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_3;
+        AT45_TransactionInit(&transaction, AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_0, 0, 0, 0);
+        transaction.header[1] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_1;
+        transaction.header[2] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_2;
+        transaction.header[3] = AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_3;
     }
     else if (targetPageSize == 528)
     {
-        AT45_Handle->CMD[0] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_0;
-        AT45_Handle->CMD[1] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_1;
-        AT45_Handle->CMD[2] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_2;
-        AT45_Handle->CMD[3] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_3;
+        AT45_TransactionInit(&transaction, AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_0, 0, 0, 0);
+        transaction.header[1] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_1;
+        transaction.header[2] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_2;
+        transaction.header[3] = AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_3;
     }
     else
         return ERROR;
+    transaction.headerLength = 4;
 
     /* Page size configuration */
-    CS_LOW(AT45_Handle);
-    AT45_SPI_Transmit(AT45_Handle->hspix, AT45_Handle->CMD, sizeof(AT45_Handle->CMD), AT45_TX_TIMEOUT);
-    CS_HIGH(AT45_Handle);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
 
     /* Wait for end of programming of the nonvolatile register */
     if (AT45_WaitWithTimeout(AT45_Handle, AT45_PAGE_ERASE_PROGRAMMING_TIME) != SUCCESS)
@@ -435,7 +863,589 @@ static ErrorStatus AT45_PageSizeConfig(AT45_HandleTypeDef *AT45_Handle, uint16_t
     return SUCCESS;
 }
 
-static uint16_t ModBus_CRC(const uint8_t *pBuffer, uint16_t bufSize)
+#ifdef AT45_USE_CLOCK_TUNING
+static void AT45_ClockTuning(AT45_HandleTypeDef *AT45_Handle)
+{
+    uint16_t initialPrescaler = AT45_Handle->baudRatePrescaler;
+    uint16_t prescaler;
+    uint8_t ID[sizeof(AT45_Handle->ID)];
+    uint8_t i;
+
+    /* Reference read at the initial clock */
+    memcpy(ID, AT45_Handle->ID, sizeof(ID));
+
+    /* From the fastest clock down to the initial one, which is known to work */
+    for (prescaler = 0; prescaler < initialPrescaler; prescaler += AT45_SPI_PRESCALER_STEP)
+    {
+        AT45_Handle->baudRatePrescaler = prescaler;
+        if (AT45_ClockVerify(AT45_Handle, ID) == SUCCESS)
+            break;
+    }
+
+    /* Safety margin */
+    for (i = 0; (i < AT45_CLOCK_TUNING_MARGIN) && (prescaler < initialPrescaler); i++)
+        prescaler += AT45_SPI_PRESCALER_STEP;
+
+    AT45_Handle->baudRatePrescaler = prescaler;
+    memcpy(AT45_Handle->ID, ID, sizeof(ID));
+}
+
+static ErrorStatus AT45_ClockVerify(AT45_HandleTypeDef *AT45_Handle, const uint8_t *ID)
+{
+    /* Every bit toggles, single bit walks across the byte */
+    static const uint8_t patternTX[] = {0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC,
+                                        0x01, 0xFE, 0x80, 0x7F, 0x10, 0xEF, 0x08, 0xF7};
+    AT45_Transaction_t transaction;
+    uint8_t patternRX[sizeof(patternTX)];
+
+    AT45_ReadID(AT45_Handle);
+    if (memcmp(AT45_Handle->ID, ID, sizeof(AT45_Handle->ID)) != 0)
+        return ERROR;
+
+    /* Known pattern round trip through Buffer 1 */
+    AT45_TransactionInit(&transaction, AT45_CMD_BUFFER_1_WRITE, 0, 3, 0);
+    transaction.pDataTX = patternTX;
+    transaction.dataLength = sizeof(patternTX);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+
+    /* BFA8-BFA0 - buffer address, 1 dummy byte */
+    AT45_TransactionInit(&transaction, AT45_CMD_BUFFER_1_READ, 0, 3, 1);
+    transaction.pDataRX = patternRX;
+    transaction.dataLength = sizeof(patternRX);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+
+    return (memcmp(patternTX, patternRX, sizeof(patternTX)) == 0) ? SUCCESS : ERROR;
+}
+#endif
+
+static void AT45_ReadOpcodeSelect(AT45_HandleTypeDef *AT45_Handle)
+{
+    uint32_t clock = AT45_SPI_GetClock(AT45_Handle->hspix, AT45_Handle->baudRatePrescaler);
+
+    /* The fewest dummy bytes, then the lowest power */
+    if (clock <= AT45_LOW_POWER_READ_MAX_CLOCK)
+    {
+        AT45_Handle->readOpcode = AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_POWER;
+        AT45_Handle->readDummyLength = 0;
+    }
+    else if (clock <= AT45_LOW_FREQUENCY_READ_MAX_CLOCK)
+    {
+        AT45_Handle->readOpcode = AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_FREQUENCY;
+        AT45_Handle->readDummyLength = 0;
+    }
+    else if (clock <= AT45_HIGH_FREQUENCY_READ_MAX_CLOCK)
+    {
+        AT45_Handle->readOpcode = AT45_CMD_CONTINUOUS_ARRAY_READ_HIGH_FREQUENCY;
+        AT45_Handle->readDummyLength = 1;
+    }
+    else
+    {
+        AT45_Handle->readOpcode = AT45_CMD_CONTINUOUS_ARRAY_READ_HIGHEST_FREQUENCY;
+        AT45_Handle->readDummyLength = 2;
+    }
+    AT45_Handle->bufferReadDummyLength = (clock <= AT45_LOW_FREQUENCY_READ_MAX_CLOCK) ? 0 : 1;
+}
+
+static void AT45_ReadVectorSort(AT45_ReadRequest_t *requests, uint16_t count)
+{
+    AT45_ReadRequest_t request;
+    uint16_t i, j;
+
+    /* Insertion sort: few fragments, no recursion and no heap */
+    for (i = 1; i < count; i++)
+    {
+        request = requests[i];
+        for (j = i; (j > 0) && (requests[j - 1].address > request.address); j--)
+            requests[j] = requests[j - 1];
+        requests[j] = request;
+    }
+}
+
+static uint16_t AT45_ReadVectorRun(AT45_HandleTypeDef *AT45_Handle, const AT45_ReadRequest_t *requests,
+                                   uint16_t count, uint16_t maxGap)
+{
+    AT45_Transaction_t transaction;
+    const AT45_ReadRequest_t *cover = &requests[0]; // Fragment, that has been received up to the position
+    uint32_t position = requests[0].address;
+    uint32_t end, overlap, gap;
+    uint8_t discard[16];
+    uint16_t i;
+
+    /* A20-A0 - byte address to start from, dummy bytes of the selected read opcode */
+    AT45_TransactionInit(&transaction, AT45_Handle->readOpcode, position, 3, AT45_Handle->readDummyLength);
+    CS_LOW(AT45_Handle);
+    AT45_Handle->ops->transfer(AT45_Handle, transaction.header, NULL, transaction.headerLength, AT45_TX_TIMEOUT);
+
+    for (i = 0; (i < count) && (requests[i].address <= (position + maxGap)); i++)
+    {
+        end = requests[i].address + requests[i].dataLength;
+
+        /* Hole is clocked through */
+        while (position < requests[i].address)
+        {
+            gap = requests[i].address - position;
+            if (gap > sizeof(discard))
+                gap = sizeof(discard);
+            AT45_Handle->ops->transfer(AT45_Handle, NULL, discard, (uint16_t) gap, AT45_RX_TIMEOUT);
+            position += gap;
+        }
+
+        /* Overlapping part has already been received by the preceding fragment */
+        overlap = ((end < position) ? end : position) - requests[i].address;
+        if (overlap != 0)
+            memcpy(requests[i].buf, &cover->buf[requests[i].address - cover->address], overlap);
+
+        if (end > position)
+        {
+            AT45_TransferData(AT45_Handle, NULL, &requests[i].buf[overlap], end - position, AT45_RX_TIMEOUT);
+            position = end;
+            cover = &requests[i];
+        }
+    }
+    CS_HIGH(AT45_Handle);
+
+    return i;
+}
+
+static ErrorStatus AT45_PageProgram(AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                                    uint32_t address, bool trailingCRC, bool pageErase)
+{
+    uint8_t bufferIndex = AT45_Handle->writeBuffer;
+    int8_t heldIndex = AT45_BufferFind(AT45_Handle, address / AT45_PAGE_SIZE);
+    const AT45_BufferOpcodes_t *opcodes;
+    AT45_Transaction_t fill;
+    AT45_Transaction_t command;
+    uint16_t frameLength = dataLength;
+    bool transfer;
+    bool ready;
+    bool fused;
+
+    if (trailingCRC)
+        frameLength += AT45_Handle->checksum->size;
+
+    /* Partial frame of the page, already held by a buffer, is merged there without the page transfer */
+    if ((frameLength < AT45_PAGE_SIZE) && (heldIndex >= 0))
+        bufferIndex = (uint8_t) heldIndex;
+    transfer = (frameLength < AT45_PAGE_SIZE) && (bufferIndex != heldIndex);
+
+    /* The buffer is written while the other one is programmed, but the transfer needs the device ready */
+    ready = transfer || READ_BIT(AT45_Handle->bufferBusy, 1u << bufferIndex);
+
+    /* No program to overlap the buffer write with: the buffer is written and programmed by one command */
+    fused = ready || !READ_BIT(AT45_Handle->bufferBusy, 1u << (bufferIndex ^ 1));
+    if (fused && !pageErase && (bufferIndex != 0))
+    {
+        /* Page Program through Buffer without Built-In Erase exists for Buffer 1 only, that is free once ready */
+        if (bufferIndex == heldIndex)
+            fused = false;
+        else
+            bufferIndex = 0;
+    }
+    opcodes = &AT45_BufferWriteOpcodes[bufferIndex];
+
+    /* The checksum is calculated while the previous page may still be programmed */
+    if (fused)
+    {
+        /* A20-A9 - page address, A8-A0 - address of the first byte in the SRAM buffer to be written */
+        AT45_TransactionInit(&fill, pageErase ? opcodes->programThroughErase : opcodes->programThrough, address, 3,
+                             0);
+    }
+    else
+    {
+        /* BFA8-BFA0 - Address of the first byte in the SRAM buffer to be written */
+        AT45_TransactionInit(&fill, opcodes->write, address % AT45_PAGE_SIZE, 3, 0);
+    }
+    fill.pDataTX = data;
+    fill.dataLength = dataLength;
+    if (trailingCRC)
+    {
+        AT45_FrameSeal(AT45_Handle, data, dataLength, fill.trailer);
+        fill.trailerLength = AT45_Handle->checksum->size;
+    }
+
+    if ((ready || fused) && (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS))
+        return ERROR;
+
+    /* Buffer contents are replaced, the page in the other buffer gets outdated */
+    AT45_Handle->bufferPage[bufferIndex] = AT45_NO_PAGE;
+    AT45_BufferInvalidate(AT45_Handle, address / AT45_PAGE_SIZE, 1);
+
+    /* Partial frame: load the page to the buffer, so the rest of the page is programmed back unchanged */
+    if (transfer)
+    {
+        /* A20-A9 - 12 page address bits that specify the page in the main memory to be transferred */
+        AT45_TransactionInit(&command, opcodes->transfer, address, 3, 0);
+        AT45_TransactionExecute(AT45_Handle, &command);
+
+        if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+            return ERROR;
+    }
+
+    /* Buffer write, the page program starts at CS rise for the fused command */
+    AT45_TransactionExecute(AT45_Handle, &fill);
+
+    /* Page program, as soon as the previous one is completed */
+    /* A20-A9 - 12 page address bits that specify the page in the main memory to be written */
+    if (!fused)
+    {
+        if (!ready && (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS))
+            return ERROR;
+        AT45_TransactionInit(&command, pageErase ? opcodes->programErase : opcodes->program, address, 3, 0);
+        AT45_TransactionExecute(AT45_Handle, &command);
+    }
+
+    /* Without erase the page becomes the old contents AND the buffer, it is mirrored only after a passing compare */
+    if (pageErase)
+        AT45_Handle->bufferPage[bufferIndex] = address / AT45_PAGE_SIZE;
+    SET_BIT(AT45_Handle->bufferBusy, 1u << bufferIndex);
+    AT45_Handle->writeBuffer = bufferIndex ^ 1;
+
+    return SUCCESS;
+}
+
+static AT45_Status_t AT45_ProgramWait(AT45_HandleTypeDef *AT45_Handle, uint8_t bufferIndex, uint32_t page,
+                                      bool pageErase, AT45_WaitForTask_t waitForTask)
+{
+    uint32_t programTime = pageErase ? AT45_PAGE_ERASE_PROGRAMMING_TIME : AT45_PAGE_PROGRAMMING_TIME;
+    AT45_Status_t result = AT45_STATUS_READY;
+
+    if (waitForTask == AT45_WAIT_DELAY)
+        AT45_Handle->ops->delay(programTime);
+    else if ((waitForTask == AT45_WAIT_BUSY) || (waitForTask == AT45_WAIT_VERIFY))
+    {
+        /* tP/tEP are maximum figures, the same margin as for AT45_Poll; EPE: the page program failed */
+        if (AT45_WaitWithTimeout(AT45_Handle, programTime + AT45_RESPONSE_TIMEOUT) != SUCCESS)
+            result = AT45_STATUS_ERROR_TIMEOUT;
+        else if (READ_BIT(AT45_Handle->statusRegister[1], 1u << 5))
+            result = AT45_STATUS_ERROR_PROGRAM;
+        else if (waitForTask == AT45_WAIT_VERIFY)
+            result = AT45_BufferCompare(AT45_Handle, bufferIndex, page);
+    }
+    if ((result == AT45_STATUS_READY) && (waitForTask == AT45_WAIT_VERIFY))
+        AT45_Handle->bufferPage[bufferIndex] = page;
+
+    /* The buffer does not hold what the page contains, so reads must not be served from it */
+    if (result != AT45_STATUS_READY)
+        AT45_Handle->bufferPage[bufferIndex] = AT45_NO_PAGE;
+
+    return result;
+}
+
+static ErrorStatus AT45_ReadPrepare(AT45_HandleTypeDef *AT45_Handle, AT45_Transaction_t *transaction,
+                                    int8_t bufferIndex, uint32_t address)
+{
+#ifdef AT45_USE_PREFETCH
+    /* The read-ahead in flight keeps CS low, e.g. before a cache fill */
+    AT45_PrefetchCollect(AT45_Handle, true);
+#endif
+    if (bufferIndex < 0)
+    {
+        if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+            return ERROR;
+
+        /* A20-A0 - byte address to start from, dummy bytes of the selected read opcode */
+        AT45_TransactionInit(transaction, AT45_Handle->readOpcode, address, 3, AT45_Handle->readDummyLength);
+    }
+    else
+    {
+        /* The buffer may be read while the device is busy, unless the buffer itself is being programmed */
+        if (READ_BIT(AT45_Handle->bufferBusy, 1u << bufferIndex) &&
+            (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS))
+            return ERROR;
+
+        /* BFA8-BFA0 - byte address within the buffer */
+        AT45_TransactionInit(transaction, AT45_BufferReadOpcodes[bufferIndex][AT45_Handle->bufferReadDummyLength],
+                             address % AT45_PAGE_SIZE, 3, AT45_Handle->bufferReadDummyLength);
+    }
+
+    return SUCCESS;
+}
+
+static void AT45_FrameSeal(const AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                           uint8_t *trailer)
+{
+    uint32_t checksum = AT45_Handle->checksum->compute(data, dataLength);
+    uint8_t i;
+
+    /* Little-endian, as ModBus CRC16 has always been stored */
+    for (i = 0; i < AT45_Handle->checksum->size; i++)
+        trailer[i] = (uint8_t) (checksum >> (8 * i));
+}
+
+static AT45_Status_t AT45_FrameCheck(const AT45_HandleTypeDef *AT45_Handle, const uint8_t *data, uint16_t dataLength,
+                                     const uint8_t *trailer, bool trailingCRC)
+{
+    uint8_t expected[AT45_CHECKSUM_MAX_SIZE];
+
+    if (!trailingCRC)
+        return AT45_STATUS_READY;
+
+    AT45_FrameSeal(AT45_Handle, data, dataLength, expected);
+    if (memcmp(trailer, expected, AT45_Handle->checksum->size) != 0)
+        return AT45_STATUS_ERROR_CHECKSUM;
+
+    return AT45_STATUS_READY;
+}
+
+static int8_t AT45_BufferFind(const AT45_HandleTypeDef *AT45_Handle, uint32_t page)
+{
+    int8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (AT45_Handle->bufferPage[i] == page)
+            return i;
+    }
+
+    return -1;
+}
+
+static void AT45_BufferInvalidate(AT45_HandleTypeDef *AT45_Handle, uint32_t firstPage, uint32_t numberOfPages)
+{
+    uint8_t i;
+
+    /* Erased pages do not match the buffers anymore */
+    for (i = 0; i < 2; i++)
+    {
+        if ((AT45_Handle->bufferPage[i] - firstPage) < numberOfPages)
+            AT45_Handle->bufferPage[i] = AT45_NO_PAGE;
+    }
+}
+
+static AT45_Status_t AT45_BufferCompare(AT45_HandleTypeDef *AT45_Handle, uint8_t bufferIndex, uint32_t page)
+{
+    AT45_Transaction_t transaction;
+
+    /* A20-A9 - page address bits, the result is in the COMP bit of the status register after tXFR */
+    AT45_TransactionInit(&transaction,
+                         bufferIndex ? AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE
+                                     : AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_COMPARE,
+                         page * AT45_PAGE_SIZE, 3, 0);
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+    if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+        return AT45_STATUS_ERROR_TIMEOUT;
+
+    /* COMP: 0 - main memory page data matches buffer data */
+    if (READ_BIT(AT45_Handle->statusRegister[0], 1u << 6))
+        return AT45_STATUS_ERROR_VERIFY;
+
+    return AT45_STATUS_READY;
+}
+
+static void AT45_OperationFinish(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Operation_t *operation = &AT45_Handle->operation;
+
+    /* Any later program or erase is started after a wait, so EPE still belongs to the tracked page program */
+    if (operation->result != AT45_STATUS_BUSY_WRITE)
+        return;
+    operation->result =
+        READ_BIT(AT45_Handle->statusRegister[1], 1u << 5) ? AT45_STATUS_ERROR_PROGRAM : AT45_STATUS_READY;
+
+    /* The page is not what the buffer holds */
+    if (operation->result != AT45_STATUS_READY)
+        AT45_BufferInvalidate(AT45_Handle, operation->page, 1);
+}
+
+#ifdef AT45_USE_PREFETCH
+static const uint8_t *AT45_PrefetchLookup(AT45_HandleTypeDef *AT45_Handle, uint32_t address)
+{
+    AT45_Prefetch_t *prefetch = &AT45_Handle->prefetch;
+    AT45_Transaction_t transaction;
+    uint32_t page = address / AT45_PAGE_SIZE;
+    bool sequential = (page == prefetch->nextPage);
+
+    prefetch->nextPage = page + 1;
+
+    /* Wait for the page in flight only if it is the requested one */
+    if (AT45_PrefetchCollect(AT45_Handle, prefetch->inFlight && (page == (prefetch->headPage + prefetch->count))) !=
+        SUCCESS)
+    {
+        AT45_PrefetchInvalidate(AT45_Handle);
+        return NULL;
+    }
+
+    if ((prefetch->count != 0) && (page >= prefetch->headPage) && (page < (prefetch->headPage + prefetch->count)))
+    {
+        /* Hit: pages behind are not needed anymore */
+        while (prefetch->headPage != page)
+        {
+            prefetch->head = (prefetch->head + 1) % prefetch->depth;
+            prefetch->headPage++;
+            prefetch->count--;
+        }
+        prefetch->hits++;
+    }
+    else
+    {
+        prefetch->misses++;
+        AT45_PrefetchInvalidate(AT45_Handle);
+        if (!sequential)
+            return NULL; // Random access is read directly to the destination
+
+        /* Sequential access detected: the requested page is the first one buffered */
+        if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+            return NULL;
+        prefetch->head = 0;
+        prefetch->headPage = page;
+        AT45_TransactionInit(&transaction, AT45_Handle->readOpcode, page * AT45_PAGE_SIZE, 3,
+                             AT45_Handle->readDummyLength);
+        transaction.pDataRX = prefetch->memory;
+        transaction.dataLength = AT45_PAGE_SIZE;
+        AT45_TransactionExecute(AT45_Handle, &transaction);
+        prefetch->count = 1;
+    }
+
+    /* The next page is received while the caller processes this one */
+    AT45_PrefetchStart(AT45_Handle);
+
+    return &prefetch->memory[(prefetch->head * AT45_PAGE_SIZE) + (address % AT45_PAGE_SIZE)];
+}
+
+static void AT45_PrefetchStart(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Prefetch_t *prefetch = &AT45_Handle->prefetch;
+    AT45_Transaction_t transaction;
+    uint32_t page = prefetch->headPage + prefetch->count;
+    uint8_t *slot = &prefetch->memory[((prefetch->head + prefetch->count) % prefetch->depth) * AT45_PAGE_SIZE];
+
+    if (prefetch->inFlight || (prefetch->count >= prefetch->depth) || (page >= AT45_Handle->numberOfPages))
+        return;
+    if (AT45_WaitWithTimeout(AT45_Handle, AT45_RESPONSE_TIMEOUT) != SUCCESS)
+        return;
+
+    AT45_TransactionInit(&transaction, AT45_Handle->readOpcode, page * AT45_PAGE_SIZE, 3,
+                         AT45_Handle->readDummyLength);
+
+    /* Without non-blocking transport the page is read ahead synchronously */
+    if (AT45_Handle->ops->submit == NULL)
+    {
+        transaction.pDataRX = slot;
+        transaction.dataLength = AT45_PAGE_SIZE;
+        AT45_TransactionExecute(AT45_Handle, &transaction);
+        prefetch->count++;
+        return;
+    }
+
+    /* CS is released by AT45_PrefetchCollect */
+    CS_LOW(AT45_Handle);
+    AT45_Handle->ops->transfer(AT45_Handle, transaction.header, NULL, transaction.headerLength, AT45_TX_TIMEOUT);
+    if (!AT45_Handle->ops->submit(AT45_Handle, NULL, slot, AT45_PAGE_SIZE))
+    {
+        CS_HIGH(AT45_Handle);
+        return;
+    }
+    prefetch->tickStart = AT45_Handle->ops->tick();
+    prefetch->inFlight = true;
+}
+
+static ErrorStatus AT45_PrefetchCollect(AT45_HandleTypeDef *AT45_Handle, bool wait)
+{
+    AT45_Prefetch_t *prefetch = &AT45_Handle->prefetch;
+
+    if (!prefetch->inFlight)
+        return SUCCESS;
+
+    while (!AT45_Handle->ops->complete(AT45_Handle))
+    {
+        if (!wait)
+            return SUCCESS;
+        if ((AT45_Handle->ops->tick() - prefetch->tickStart) >= AT45_RX_TIMEOUT)
+        {
+            /* The transfer is stopped before CS rise, so it neither fills the slot later nor signals completion */
+            if (AT45_Handle->ops->abort != NULL)
+                AT45_Handle->ops->abort(AT45_Handle);
+            CS_HIGH(AT45_Handle);
+            prefetch->inFlight = false;
+            prefetch->count = 0;
+            return ERROR;
+        }
+    }
+    CS_HIGH(AT45_Handle);
+    prefetch->inFlight = false;
+    prefetch->count++;
+
+    return SUCCESS;
+}
+
+static void AT45_PrefetchInvalidate(AT45_HandleTypeDef *AT45_Handle)
+{
+    if (AT45_Handle->prefetch.depth == 0)
+        return;
+
+    AT45_PrefetchCollect(AT45_Handle, true);
+    AT45_Handle->prefetch.count = 0;
+}
+#endif
+
+#ifdef AT45_USE_CACHE
+static AT45_CacheSlot_t *AT45_CacheLookup(AT45_HandleTypeDef *AT45_Handle, int8_t bufferIndex, uint32_t page)
+{
+    AT45_Cache_t *cache = &AT45_Handle->cache;
+    AT45_CacheSlot_t *victim = &cache->slots[0];
+    AT45_Transaction_t transaction;
+    uint8_t i;
+
+    cache->useCount++;
+    for (i = 0; i < cache->count; i++)
+    {
+        if (cache->slots[i].page == page)
+        {
+            cache->slots[i].lastUse = cache->useCount;
+            cache->hits++;
+            return &cache->slots[i];
+        }
+
+        /* Empty slot first, then the least recently used one; the age is wrap-safe */
+        if (victim->page == AT45_NO_PAGE)
+            continue;
+        if ((cache->slots[i].page == AT45_NO_PAGE) ||
+            ((cache->useCount - cache->slots[i].lastUse) > (cache->useCount - victim->lastUse)))
+            victim = &cache->slots[i];
+    }
+    cache->misses++;
+
+    /* The page, held by an SRAM buffer, is filled from the buffer */
+    if (AT45_ReadPrepare(AT45_Handle, &transaction, bufferIndex, page * AT45_PAGE_SIZE) != SUCCESS)
+        return NULL;
+    if (victim->page != AT45_NO_PAGE)
+        cache->evictions++;
+    victim->page = AT45_NO_PAGE;
+    transaction.pDataRX = victim->data;
+    transaction.dataLength = AT45_PAGE_SIZE;
+    AT45_TransactionExecute(AT45_Handle, &transaction);
+    victim->page = page;
+    victim->lastUse = cache->useCount;
+
+    return victim;
+}
+
+static void AT45_CacheInvalidate(AT45_HandleTypeDef *AT45_Handle, uint32_t firstPage, uint32_t numberOfPages)
+{
+    AT45_Cache_t *cache = &AT45_Handle->cache;
+    uint8_t i;
+
+    for (i = 0; i < cache->count; i++)
+    {
+        if ((cache->slots[i].page - firstPage) < numberOfPages)
+            cache->slots[i].page = AT45_NO_PAGE;
+    }
+}
+#endif
+
+static uint32_t ModBus_CRC(const uint8_t *pBuffer, uint16_t bufSize)
+{
+    uint16_t CRC16 = 0xffff;
+    uint16_t i;
+
+    /* One table lookup per byte instead of 8 shifts */
+    for (i = 0; i < bufSize; i++)
+        CRC16 = (CRC16 >> 8) ^ ModBus_CRC_Table[(uint8_t) (CRC16 ^ pBuffer[i])];
+
+    return CRC16;
+}
+
+static uint32_t ModBus_CRC_Bitwise(const uint8_t *pBuffer, uint16_t bufSize)
 {
     uint16_t CRC16 = 0xffff;
     uint16_t i, j;
@@ -453,4 +1463,4 @@ static uint16_t ModBus_CRC(const uint8_t *pBuffer, uint16_t bufSize)
     }
 
     return CRC16;
-}
\ No newline at end of file
+}
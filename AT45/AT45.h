@@ -5,6 +5,18 @@
 
 /* Instruction Set */
 #define AT45_CMD_MAIN_MEMORY_PAGE_READ                           0xD2
+#define AT45_CMD_CONTINUOUS_ARRAY_READ_HIGHEST_FREQUENCY         0x1B
+#define AT45_CMD_CONTINUOUS_ARRAY_READ_HIGH_FREQUENCY            0x0B
+#define AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_FREQUENCY             0x03
+#define AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_POWER                 0x01
+#define AT45_CMD_BUFFER_1_READ                                   0xD4
+#define AT45_CMD_BUFFER_2_READ                                   0xD6
+#define AT45_CMD_BUFFER_1_READ_LOW_FREQUENCY                     0xD1
+#define AT45_CMD_BUFFER_2_READ_LOW_FREQUENCY                     0xD3
+#define AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_TRANSFER           0x53
+#define AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER           0x55
+#define AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_COMPARE            0x60
+#define AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE            0x61
 #define AT45_CMD_BUFFER_1_WRITE                                  0x84
 #define AT45_CMD_BUFFER_2_WRITE                                  0x87
 #define AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE      0x83
@@ -45,22 +57,33 @@
 #define AT45_RX_TIMEOUT       100
 #define AT45_RESPONSE_TIMEOUT 100
 
+/* Read clock limits [Hz] */
+#define AT45_LOW_POWER_READ_MAX_CLOCK      15000000 // fCAR3, 0x01
+#define AT45_LOW_FREQUENCY_READ_MAX_CLOCK  50000000 // fCAR2, 0x03; fBUF, 0xD1 and 0xD3
+#define AT45_HIGH_FREQUENCY_READ_MAX_CLOCK 85000000 // fCAR1, 0x0B; 0x1B above
+
+/* Hole [bytes], that AT45_ReadVector callers may read through rather than issue a new command */
+#define AT45_READ_VECTOR_GAP 16
+
+/* Longest single SPI call [bytes]: 50 ms at fPCLK1/256 fits AT45_TX_TIMEOUT and AT45_RX_TIMEOUT */
+#define AT45_TRANSFER_CHUNK_SIZE 1024
+
+/* Longest frame trailer [bytes], that a checksum may occupy */
+#define AT45_CHECKSUM_MAX_SIZE 4
+
 /* Device constants */
 #define AT45_MANUFACTURER_ID 0x1F
 #define AT45_PAGE_SIZE       512
 #define AT45_BLOCK_SIZE      ((AT45_PAGE_SIZE) * 8)
 #define AT45_SECTOR_SIZE     ((AT45_PAGE_SIZE) * 256)
+#define AT45_NO_PAGE         UINT32_MAX
 
 enum AT45_DeviceID_e { AT45DB021 = 0x23, AT45DB041, AT45DB081, AT45DB161, AT45DB321, AT45DB641 };
 
 /* Macro */
 #define KB_TO_BYTE(KB)         ((KB) * 1024)
-#define CS_HIGH(DEVICE_HANDLE) SET_BIT((DEVICE_HANDLE)->CS_Port->BSRR, (DEVICE_HANDLE)->CS_Pin)
-#define CS_LOW(DEVICE_HANDLE)  SET_BIT((DEVICE_HANDLE)->CS_Port->BSRR, (DEVICE_HANDLE)->CS_Pin << 16)
-#define ADDRESS_BYTES_SWAP(DEVICE_HANDLE, ADDRESS)                  \
-    (DEVICE_HANDLE)->addressBytes[0] = (uint8_t) ((ADDRESS) >> 16); \
-    (DEVICE_HANDLE)->addressBytes[1] = (uint8_t) ((ADDRESS) >> 8);  \
-    (DEVICE_HANDLE)->addressBytes[2] = (uint8_t) ((ADDRESS) >> 0)
+#define CS_HIGH(DEVICE_HANDLE) (DEVICE_HANDLE)->ops->deselect(DEVICE_HANDLE)
+#define CS_LOW(DEVICE_HANDLE)  (DEVICE_HANDLE)->ops->select(DEVICE_HANDLE)
 
 /* Data types */
 typedef enum AT45_EraseInstruction_e {
@@ -70,7 +93,12 @@ typedef enum AT45_EraseInstruction_e {
     AT45_CHIP_ERASE
 } AT45_EraseInstruction_t;
 
-typedef enum AT45_WaitForTask_e { AT45_WAIT_NO, AT45_WAIT_DELAY, AT45_WAIT_BUSY } AT45_WaitForTask_t;
+typedef enum AT45_WaitForTask_e {
+    AT45_WAIT_NO,
+    AT45_WAIT_DELAY,
+    AT45_WAIT_BUSY,
+    AT45_WAIT_VERIFY // Wait busy, then compare the programmed page with the SRAM buffer (write only)
+} AT45_WaitForTask_t;
 
 typedef enum AT45_Status_e {
     AT45_STATUS_RESET,
@@ -81,24 +109,101 @@ typedef enum AT45_Status_e {
     AT45_STATUS_ERROR_INITIALIZATION,
     AT45_STATUS_ERROR_ARGUMENT,
     AT45_STATUS_ERROR_TIMEOUT,
-    AT45_STATUS_ERROR_MEM_MANAGE,
+    AT45_STATUS_ERROR_MEM_MANAGE, // Not returned since reads are heap-free, kept for compatibility
     AT45_STATUS_ERROR_CHECKSUM,
-    AT45_STATUS_ERROR_INSTRUCTION
+    AT45_STATUS_ERROR_INSTRUCTION,
+    AT45_STATUS_ERROR_VERIFY,
+    AT45_STATUS_ERROR_PROGRAM // EPE bit of the status register: the page program or erase failed
 } AT45_Status_t;
 
+/* Page program, started by AT45_WriteAsync and tracked until its completion is delivered */
+typedef struct AT45_Operation_s
+{
+    uint32_t token; // 0 - no operation to deliver
+    uint32_t page;
+    uint32_t tickStart;
+    uint32_t duration; // Expected programming time [ms], the deadline is tickStart + duration
+    AT45_Status_t result; // AT45_STATUS_BUSY_WRITE while the page is programmed
+} AT45_Operation_t;
+
+/* Fragment of the vectored read */
+typedef struct AT45_ReadRequest_s
+{
+    uint32_t address; // Byte address
+    uint16_t dataLength;
+    uint8_t *buf; // Destination
+} AT45_ReadRequest_t;
+
+#ifdef AT45_USE_PREFETCH
+/* Ring of consecutive pages, read ahead of sequential access */
+typedef struct AT45_Prefetch_s
+{
+    uint8_t *memory; // depth * AT45_PAGE_SIZE bytes
+    uint8_t depth; // 0 - prefetch is disabled
+    uint8_t head; // Slot of headPage
+    uint8_t count; // Received pages: headPage...headPage + count - 1
+    bool inFlight; // Page headPage + count is being received, CS is low
+    uint32_t tickStart;
+    uint32_t headPage;
+    uint32_t nextPage; // Page, that continues sequential access, AT45_NO_PAGE - none
+    uint32_t hits;
+    uint32_t misses;
+} AT45_Prefetch_t;
+#endif
+
+#ifdef AT45_USE_CACHE
+/* Cached copy of a main memory page */
+typedef struct AT45_CacheSlot_s
+{
+    uint32_t page; // AT45_NO_PAGE - empty
+    uint32_t lastUse; // Value of the cache use counter at the last hit or fill
+    uint8_t data[AT45_PAGE_SIZE];
+} AT45_CacheSlot_t;
+
+/* Pages, read repeatedly, with least recently used eviction */
+typedef struct AT45_Cache_s
+{
+    AT45_CacheSlot_t *slots;
+    uint8_t count; // 0 - cache is disabled
+    uint32_t useCount;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions; // Misses, that replaced a cached page
+} AT45_Cache_t;
+#endif
+
 typedef struct AT45_HandleTypeDef_s
 {
+    const AT45_Ops_t *ops;
+    const AT45_Checksum_t *checksum; // Trailer of frames, written and read with trailingCRC
     SPI_HandleTypeDef *hspix;
     GPIO_TypeDef *CS_Port;
     uint16_t CS_Pin;
+    uint16_t baudRatePrescaler; // SPI_CR1_BR value, applied on every CS assertion
+    uint8_t readOpcode; // Cheapest Continuous Array Read, legal at the device SPI clock
+    uint8_t readDummyLength;
+    uint8_t bufferReadDummyLength; // 0 - Buffer Read (Low Frequency), 1 - Buffer Read
+    uint32_t bufferPage[2]; // Page, SRAM buffer 1/2 holds the contents of, AT45_NO_PAGE - none
+    uint8_t bufferBusy; // Buffers, the started program may still use: bit 0 - buffer 1, bit 1 - buffer 2
+    uint8_t writeBuffer; // SRAM buffer of the next page program, buffers alternate
     uint8_t ID[5];
     uint8_t statusRegister[2];
-    uint8_t addressBytes[3];
-    uint8_t CMD[4];
     uint32_t numberOfPages;
     AT45_Status_t status;
+    AT45_Operation_t operation;
+    uint32_t operationCount; // Last issued token
+#ifdef AT45_USE_PREFETCH
+    AT45_Prefetch_t prefetch;
+#endif
+#ifdef AT45_USE_CACHE
+    AT45_Cache_t cache;
+#endif
 } AT45_HandleTypeDef;
 
+/* Predefined checksums */
+extern const AT45_Checksum_t AT45_ModBusChecksum; // ModBus CRC16, table-driven
+extern const AT45_Checksum_t AT45_ModBusBitwiseChecksum; // ModBus CRC16, bit by bit without table
+
 /**
  * @brief Checks if the device is available and determines the number of pages
  * @param AT45_Handle: pointer to the device handle structure
@@ -106,6 +211,10 @@ typedef struct AT45_HandleTypeDef_s
  * @param CS_Port: GPIOx
  * @param CS_Pin: GPIO_Pin_x
  * @return Device status
+ * @note Transport may be selected by the ops field before the call, NULL - AT45_PollingOps
+ * @note Checksum may be selected by the checksum field before the call, NULL - AT45_ModBusChecksum; frames, written
+ * with one checksum, can be read with the same one only
+ * @note The current SPI clock is kept for the device, with AT45_USE_CLOCK_TUNING the fastest reliable one is chosen
  */
 AT45_Status_t AT45_Init(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspix, GPIO_TypeDef *CS_Port,
                         uint16_t CS_Pin);
@@ -115,27 +224,129 @@ AT45_Status_t AT45_Init(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspi
  * @param AT45_Handle: pointer to the device handle structure
  * @param buf: pointer to external buffer, that contains the data to write
  * @param dataLength: number of bytes to write
- * @param address: page address to write (multiple of 512 bytes)
- * @param trailingCRC: insert or not insert CRC at the end of frame
+ * @param address: byte address to write, the frame (data and CRC) must not cross the page boundary
+ * @param trailingCRC: insert or not insert the device checksum at the end of frame
  * @param pageErase: erase or not erase page before the write operation
  * @param waitForTask: the way to ensure that operation is completed
  * @return Device status
+ * @note The rest of the page is preserved: a frame shorter than the page is merged with the page contents
+ * transferred to the SRAM buffer first, that costs tXFR
+ * @note Page programs alternate between Buffer 1 and Buffer 2: a whole page is written to one buffer while the
+ * previous page is still programmed from the other one, so sequential writes with AT45_WAIT_NO hide the SPI fill
+ * behind tP/tEP
+ * @note With no program to overlap the buffer write with, the buffer is written and programmed by one Main Memory
+ * Page Program through Buffer command; without page erase that is Buffer 1 only
+ * @note AT45_WAIT_VERIFY compares the programmed page with its SRAM buffer on chip, AT45_STATUS_ERROR_VERIFY is
+ * returned on mismatch; that costs tXFR and a few bytes on the bus instead of reading the page back
  */
 AT45_Status_t AT45_Write(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, uint16_t dataLength, uint32_t address,
                          bool trailingCRC, bool pageErase, AT45_WaitForTask_t waitForTask);
 
+/**
+ * @brief Writes data of any length from external buffer, crossing page boundaries
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param buf: pointer to external buffer, that contains the data to write
+ * @param dataLength: number of bytes to write
+ * @param address: byte address to start from
+ * @param trailingCRC: insert or not insert the device checksum at the end of every page frame
+ * @param pageErase: erase or not erase pages before programming
+ * @param waitForTask: the way to ensure that the last page program is completed, AT45_WAIT_VERIFY compares every page
+ * @return Device status
+ * @note Data is split into one frame per page: the leading frame runs from the address to the end of its page,
+ * the following ones start at the page start; with trailingCRC each frame is AT45_PAGE_SIZE - checksum size bytes
+ * at most and may be read back by AT45_Read with trailingCRC
+ * @note Leading and trailing partial pages keep the rest of their contents, as AT45_Write does
+ * @note Each whole page is written to one SRAM buffer while the previous page is programmed from the other one
+ * @note With AT45_WAIT_BUSY and AT45_WAIT_VERIFY the EPE of every page is checked, the stream stops at the first
+ * failed page with AT45_STATUS_ERROR_PROGRAM
+ */
+AT45_Status_t AT45_WriteStream(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, uint32_t dataLength,
+                               uint32_t address, bool trailingCRC, bool pageErase, AT45_WaitForTask_t waitForTask);
+
+/**
+ * @brief Updates a few bytes of the page in place, without a page copy in RAM
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param address: byte address of the page start
+ * @param offset: offset of the first byte to update within the page
+ * @param data: pointer to external buffer, that contains the new bytes
+ * @param dataLength: number of bytes to update, the bytes must not cross the page boundary
+ * @param waitForTask: the way to ensure that operation is completed
+ * @return Device status
+ * @note The page is transferred to an SRAM buffer on chip, only the new bytes are sent and the buffer is programmed
+ * with built-in erase: a dozen bytes on the bus besides the data
+ * @note The page still held by an SRAM buffer after a previous write is updated there without the transfer
+ * @note No checksum is written: a frame covering the updated bytes has to be rewritten by AT45_Write
+ */
+AT45_Status_t AT45_Update(AT45_HandleTypeDef *AT45_Handle, uint32_t address, uint16_t offset, const uint8_t *data,
+                          uint16_t dataLength, AT45_WaitForTask_t waitForTask);
+
+/**
+ * @brief Starts writing data to ROM from external buffer and returns while the page is programmed
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param buf: pointer to external buffer, that contains the data to write
+ * @param dataLength: number of bytes to write
+ * @param address: byte address to write, the frame (data and CRC) must not cross the page boundary
+ * @param trailingCRC: insert or not insert the device checksum at the end of frame
+ * @param pageErase: erase or not erase page before the write operation
+ * @param token: pointer to the token of the started operation, may be NULL
+ * @return AT45_STATUS_BUSY_WRITE if the program is started, error status otherwise
+ * @note The frame is written as AT45_Write does; the handle records the page and the deadline in its operation field
+ * @note Completion is reported by AT45_Poll, or by the next AT45_WriteAsync, through AT45_WriteCpltCallback;
+ * any other call, that waits for the device, records the result to be delivered later
+ * @note The EPE bit of the status register turns the result to AT45_STATUS_ERROR_PROGRAM
+ */
+AT45_Status_t AT45_WriteAsync(AT45_HandleTypeDef *AT45_Handle, const uint8_t *buf, uint16_t dataLength,
+                              uint32_t address, bool trailingCRC, bool pageErase, uint32_t *token);
+
 /**
  * @brief Reades data from ROM to external buffer
  * @param AT45_Handle: pointer to the device handle structure
  * @param buf: pointer to external buffer, that will contain the received data
  * @param dataLength: number of bytes to read
- * @param address: page address to read (multiple of 512 bytes)
- * @param trailingCRC: compare or not compare CRC at the end of frame
+ * @param address: byte address to read, the frame (data and CRC) must not cross the page boundary
+ * @param trailingCRC: compare or not compare the device checksum at the end of frame
  * @return Device status
+ * @note Data is received directly to the buffer without heap use, so it is overwritten even on checksum error
+ * @note The page, last written through an SRAM buffer, is read back from the buffer without waiting for the end of
+ * programming; the written data is returned, not the main memory contents
  */
 AT45_Status_t AT45_Read(AT45_HandleTypeDef *AT45_Handle, uint8_t *buf, uint16_t dataLength, uint32_t address,
                         bool trailingCRC);
 
+/**
+ * @brief Reads data from ROM to external buffer continuously, crossing page boundaries
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param buf: pointer to external buffer, that will contain the received data
+ * @param dataLength: number of bytes to read, up to the end of memory array
+ * @param address: byte address to start from
+ * @return Device status
+ * @note The whole range is clocked out within a single CS assertion
+ */
+AT45_Status_t AT45_ReadStream(AT45_HandleTypeDef *AT45_Handle, uint8_t *buf, uint32_t dataLength, uint32_t address);
+
+/**
+ * @brief Reads scattered fragments with as few continuous reads as possible
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param requests: array of fragments, sorted by address in place
+ * @param count: number of fragments
+ * @param maxGap: largest hole between fragments [bytes], that is read through instead of a new command,
+ * AT45_READ_VECTOR_GAP - default
+ * @return Device status
+ * @note Fragments may cross page boundaries and overlap each other, no CRC is checked
+ */
+AT45_Status_t AT45_ReadVector(AT45_HandleTypeDef *AT45_Handle, AT45_ReadRequest_t *requests, uint16_t count,
+                              uint16_t maxGap);
+
+/**
+ * @brief Compares the main memory page with the SRAM buffer, last written to it, on chip
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param address: byte address within the page to verify
+ * @return Device status, AT45_STATUS_ERROR_VERIFY - the page differs from the written data
+ * @note Only the page, last written through an SRAM buffer, can be verified, AT45_STATUS_ERROR_ARGUMENT otherwise
+ * @note Waits for the end of programming, the page is not transferred over SPI
+ */
+AT45_Status_t AT45_Verify(AT45_HandleTypeDef *AT45_Handle, uint32_t address);
+
 /**
  * @brief Begins erase operation of page, block, sector or whole memory array
  * @param AT45_Handle: pointer to the device handle structure
@@ -144,6 +355,7 @@ AT45_Status_t AT45_Read(AT45_HandleTypeDef *AT45_Handle, uint8_t *buf, uint16_t
  * @param waitForTask: the way to ensure that operation is completed
  * @return Device status
  * @note Address has to be 0 in case of chip erase
+ * @note AT45_WAIT_VERIFY acts as AT45_WAIT_BUSY, there is no buffer to compare the erased pages with
  */
 AT45_Status_t AT45_Erase(AT45_HandleTypeDef *AT45_Handle, AT45_EraseInstruction_t eraseInstruction, uint32_t address,
                          AT45_WaitForTask_t waitForTask);
@@ -155,4 +367,62 @@ AT45_Status_t AT45_Erase(AT45_HandleTypeDef *AT45_Handle, AT45_EraseInstruction_
  */
 bool AT45_Busy(AT45_HandleTypeDef *AT45_Handle);
 
+/**
+ * @brief Checks the operation started by AT45_WriteAsync, does not wait
+ * @param AT45_Handle: pointer to the device handle structure
+ * @return AT45_STATUS_BUSY_WRITE while the page is programmed, then the result of the last operation
+ * @note One status register read per call; AT45_STATUS_ERROR_TIMEOUT is reported when the device is still busy
+ * AT45_RESPONSE_TIMEOUT after the deadline
+ * @note May be called from the main loop, the callback of a completed operation is called from here
+ */
+AT45_Status_t AT45_Poll(AT45_HandleTypeDef *AT45_Handle);
+
+/**
+ * @brief Completion callback of the operation started by AT45_WriteAsync
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param token: token of the completed operation
+ * @param result: AT45_STATUS_READY, AT45_STATUS_ERROR_PROGRAM or AT45_STATUS_ERROR_TIMEOUT
+ * @note Weak empty definition is provided, the application may override it; the library may be called from it
+ */
+void AT45_WriteCpltCallback(AT45_HandleTypeDef *AT45_Handle, uint32_t token, AT45_Status_t result);
+
+#ifdef AT45_USE_PREFETCH
+/**
+ * @brief Configures the sequential read-ahead of the device
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param memory: pointer to depth * AT45_PAGE_SIZE bytes, used as page buffers
+ * @param depth: number of page buffers, 2 - double buffering, 0 - prefetch is disabled
+ * @return Device status
+ * @note Has to be called after AT45_Init, which disables the prefetch
+ * @note When AT45_Read reaches the page next to the previous one, the page and the following ones are buffered;
+ * the next page is received by ops->submit while the caller processes the current one
+ * @note CS stays low while the page is received, the SPI bus must not be used by other devices until
+ * any call for this device (AT45_Read, AT45_PrefetchPoll, ...) completes the transfer
+ */
+AT45_Status_t AT45_PrefetchConfig(AT45_HandleTypeDef *AT45_Handle, uint8_t *memory, uint8_t depth);
+
+/**
+ * @brief Collects the received page and starts receiving the next one, does not wait
+ * @param AT45_Handle: pointer to the device handle structure
+ * @return Device status
+ * @note May be called from the main loop to keep the read-ahead going between reads
+ */
+AT45_Status_t AT45_PrefetchPoll(AT45_HandleTypeDef *AT45_Handle);
+#endif
+
+#ifdef AT45_USE_CACHE
+/**
+ * @brief Configures the page cache of the device
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param slots: pointer to count cache slots, a static arena of the caller
+ * @param count: number of cached pages, 0 - cache is disabled
+ * @return Device status
+ * @note Has to be called after AT45_Init, which disables the cache; statistics are cleared
+ * @note AT45_Read of an uncached page reads the whole page into the least recently used slot, then hits cost
+ * no SPI transfer; AT45_Write and AT45_Erase drop the affected pages
+ * @note Hit/miss statistics are kept in the cache field of the handle to size the cache
+ */
+AT45_Status_t AT45_CacheConfig(AT45_HandleTypeDef *AT45_Handle, AT45_CacheSlot_t *slots, uint8_t count);
+#endif
+
 #endif
\ No newline at end of file
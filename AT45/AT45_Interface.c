@@ -1,4 +1,66 @@
-#include "AT45_Interface.h"
+#include "AT45.h"
+
+/* Private function prototypes */
+static void AT45_PollingTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                                 uint32_t timeout);
+static void AT45_Select(AT45_HandleTypeDef *AT45_Handle);
+static void AT45_Deselect(AT45_HandleTypeDef *AT45_Handle);
+#ifdef AT45_USE_HW_CRC
+static uint32_t AT45_CRC32Compute(const uint8_t *data, uint16_t dataLength);
+#endif
+
+#ifdef AT45_USE_ASYNC
+/* Handles with a transfer in progress on SPI1-3, NULL when complete */
+static SPI_HandleTypeDef *volatile AT45_SPI_Pending[3];
+
+static void AT45_DMATransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout);
+static bool AT45_DMASubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size);
+static void AT45_ITTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                            uint32_t timeout);
+static bool AT45_ITSubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size);
+static bool AT45_AsyncComplete(AT45_HandleTypeDef *AT45_Handle);
+static void AT45_AsyncAbort(AT45_HandleTypeDef *AT45_Handle);
+static uint8_t AT45_SPI_Index(SPI_HandleTypeDef *hspix);
+static void AT45_SPI_WaitForCplt(SPI_HandleTypeDef *hspix, uint32_t timeout);
+#endif
+
+/* Predefined transports */
+const AT45_Ops_t AT45_PollingOps = {
+    .transfer = AT45_PollingTransfer,
+    .select = AT45_Select,
+    .deselect = AT45_Deselect,
+    .delay = AT45_Delay,
+    .tick = AT45_GetTick,
+    .submit = NULL,
+    .complete = NULL,
+    .abort = NULL};
+
+#ifdef AT45_USE_ASYNC
+const AT45_Ops_t AT45_DMAOps = {
+    .transfer = AT45_DMATransfer,
+    .select = AT45_Select,
+    .deselect = AT45_Deselect,
+    .delay = AT45_Delay,
+    .tick = AT45_GetTick,
+    .submit = AT45_DMASubmit,
+    .complete = AT45_AsyncComplete,
+    .abort = AT45_AsyncAbort};
+
+const AT45_Ops_t AT45_ITOps = {
+    .transfer = AT45_ITTransfer,
+    .select = AT45_Select,
+    .deselect = AT45_Deselect,
+    .delay = AT45_Delay,
+    .tick = AT45_GetTick,
+    .submit = AT45_ITSubmit,
+    .complete = AT45_AsyncComplete,
+    .abort = AT45_AsyncAbort};
+#endif
+
+#ifdef AT45_USE_HW_CRC
+const AT45_Checksum_t AT45_CRC32Checksum = {.size = sizeof(uint32_t), .compute = AT45_CRC32Compute};
+#endif
 
 void AT45_SPI_Transmit(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
 {
@@ -6,7 +68,7 @@ void AT45_SPI_Transmit(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size,
     if (HAL_SPI_Transmit(hspix, pData, size, timeout) != HAL_OK)
         Error_Handler();
 #else
-    if (SPI_Transmit(hspix, pData, size, timeout) != SPI_STATE_READY)
+    if (SPI_TransmitReceive(hspix, pData, NULL, size, timeout) != SPI_STATE_READY)
         Error_Handler();
 #endif
 }
@@ -17,7 +79,7 @@ void AT45_SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, u
     if (HAL_SPI_Receive(hspix, pData, size, timeout) != HAL_OK)
         Error_Handler();
 #else
-    if (SPI_Receive(hspix, pData, size, timeout) != SPI_STATE_READY)
+    if (SPI_TransmitReceive(hspix, NULL, pData, size, timeout) != SPI_STATE_READY)
         Error_Handler();
 #endif
 }
@@ -29,4 +91,300 @@ void AT45_Delay(uint32_t ms)
 #else
     Delay(ms);
 #endif
-}
\ No newline at end of file
+}
+
+uint32_t AT45_GetTick(void)
+{
+    return uwTick;
+}
+
+uint16_t AT45_SPI_GetPrescaler(SPI_HandleTypeDef *hspix)
+{
+    return (uint16_t) READ_BIT(hspix->Instance->CR1, SPI_CR1_BR);
+}
+
+void AT45_SPI_SetPrescaler(SPI_HandleTypeDef *hspix, uint16_t prescaler)
+{
+    if (AT45_SPI_GetPrescaler(hspix) == prescaler)
+        return;
+#ifdef USE_HAL_DRIVER
+    /* SPE is set again by the next transfer */
+    hspix->Init.BaudRatePrescaler = prescaler;
+    __HAL_SPI_DISABLE(hspix);
+    MODIFY_REG(hspix->Instance->CR1, SPI_CR1_BR, prescaler);
+#else
+    /* A stuck bus is reported, not waited for forever */
+    if (SPI_BaudRateConfig(hspix, prescaler, AT45_TX_TIMEOUT) != SPI_STATE_READY)
+        Error_Handler();
+#endif
+}
+
+uint32_t AT45_SPI_GetClock(SPI_HandleTypeDef *hspix, uint16_t prescaler)
+{
+    uint32_t busClock;
+
+#ifdef USE_HAL_DRIVER
+    busClock = (hspix->Instance == SPI1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+#else
+    busClock = SPI_GetBusClock(hspix);
+#endif
+
+    /* fPCLK/2...fPCLK/256 */
+    return busClock >> ((prescaler / AT45_SPI_PRESCALER_STEP) + 1);
+}
+
+#ifdef AT45_USE_HW_CRC
+uint32_t AT45_CRC_Calculate(const uint8_t *pData, uint16_t size)
+{
+    uint32_t word;
+    uint16_t i;
+
+    SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_CRCEN);
+    CRC->CR = CRC_CR_RESET;
+
+    /* One word per 4 AHB cycles */
+    for (i = 0; (i + sizeof(word)) <= size; i += sizeof(word))
+    {
+        memcpy(&word, &pData[i], sizeof(word));
+        CRC->DR = word;
+    }
+    if (i < size)
+    {
+        word = 0;
+        memcpy(&word, &pData[i], size - i);
+        CRC->DR = word;
+    }
+
+    return CRC->DR;
+}
+#endif
+
+#ifdef AT45_USE_ASYNC
+void AT45_SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    AT45_SPI_Pending[AT45_SPI_Index(hspix)] = hspix;
+#ifdef USE_HAL_DRIVER
+    if (HAL_SPI_Transmit_DMA(hspix, pData, size) != HAL_OK)
+        Error_Handler();
+#else
+    if (SPI_Transmit_DMA(hspix, pData, size) != SPI_STATE_BUSY_TX)
+        Error_Handler();
+#endif
+    if (timeout != 0)
+        AT45_SPI_WaitForCplt(hspix, timeout);
+}
+
+void AT45_SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    AT45_SPI_Pending[AT45_SPI_Index(hspix)] = hspix;
+#ifdef USE_HAL_DRIVER
+    if (HAL_SPI_Receive_DMA(hspix, pData, size) != HAL_OK)
+        Error_Handler();
+#else
+    if (SPI_Receive_DMA(hspix, pData, size) != SPI_STATE_BUSY_RX)
+        Error_Handler();
+#endif
+    if (timeout != 0)
+        AT45_SPI_WaitForCplt(hspix, timeout);
+}
+
+void AT45_SPI_Transmit_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    AT45_SPI_Pending[AT45_SPI_Index(hspix)] = hspix;
+#ifdef USE_HAL_DRIVER
+    if (HAL_SPI_Transmit_IT(hspix, pData, size) != HAL_OK)
+        Error_Handler();
+#else
+    if (SPI_Transmit_IT(hspix, pData, size) != SPI_STATE_BUSY_TX)
+        Error_Handler();
+#endif
+    if (timeout != 0)
+        AT45_SPI_WaitForCplt(hspix, timeout);
+}
+
+void AT45_SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    AT45_SPI_Pending[AT45_SPI_Index(hspix)] = hspix;
+#ifdef USE_HAL_DRIVER
+    if (HAL_SPI_Receive_IT(hspix, pData, size) != HAL_OK)
+        Error_Handler();
+#else
+    if (SPI_Receive_IT(hspix, pData, size) != SPI_STATE_BUSY_RX)
+        Error_Handler();
+#endif
+    if (timeout != 0)
+        AT45_SPI_WaitForCplt(hspix, timeout);
+}
+
+void AT45_SPI_Abort(SPI_HandleTypeDef *hspix)
+{
+#ifdef USE_HAL_DRIVER
+    if (HAL_SPI_Abort(hspix) != HAL_OK)
+        Error_Handler();
+#else
+    if (SPI_Abort(hspix) != SPI_STATE_READY)
+        Error_Handler();
+#endif
+    AT45_SPI_Pending[AT45_SPI_Index(hspix)] = NULL;
+}
+
+void AT45_SPI_TransferCplt(SPI_HandleTypeDef *hspix)
+{
+    uint8_t index = AT45_SPI_Index(hspix);
+
+    /* Transfers of other drivers are ignored */
+    if (AT45_SPI_Pending[index] == hspix)
+        AT45_SPI_Pending[index] = NULL;
+}
+
+void AT45_SPI_TransferError(SPI_HandleTypeDef *hspix)
+{
+    if (AT45_SPI_Pending[AT45_SPI_Index(hspix)] == hspix)
+        Error_Handler();
+}
+
+__weak void AT45_SPI_Idle(void)
+{
+    /* May be redefined in user code */
+}
+
+/**
+ * @section Completion callbacks
+ */
+/* Strong definitions: the HAL ones are weak stubs, two weak definitions would be resolved by the link order */
+#ifndef AT45_USE_APP_SPI_CALLBACKS
+#ifdef USE_HAL_DRIVER
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    AT45_SPI_TransferCplt(hspi);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    AT45_SPI_TransferCplt(hspi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    AT45_SPI_TransferCplt(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    AT45_SPI_TransferError(hspi);
+}
+#else
+void SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspix)
+{
+    AT45_SPI_TransferCplt(hspix);
+}
+#endif
+#endif
+#endif
+
+/**
+ * @section Private functions
+ */
+static void AT45_PollingTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                                 uint32_t timeout)
+{
+    if (pRX == NULL)
+        AT45_SPI_Transmit(AT45_Handle->hspix, (uint8_t *) pTX, size, timeout);
+    else
+        AT45_SPI_Receive(AT45_Handle->hspix, pRX, size, timeout);
+}
+
+static void AT45_Select(AT45_HandleTypeDef *AT45_Handle)
+{
+    /* Devices on the same bus may run at different clocks */
+    AT45_SPI_SetPrescaler(AT45_Handle->hspix, AT45_Handle->baudRatePrescaler);
+    SET_BIT(AT45_Handle->CS_Port->BSRR, AT45_Handle->CS_Pin << 16);
+}
+
+static void AT45_Deselect(AT45_HandleTypeDef *AT45_Handle)
+{
+    SET_BIT(AT45_Handle->CS_Port->BSRR, AT45_Handle->CS_Pin);
+}
+
+#ifdef AT45_USE_ASYNC
+static void AT45_DMATransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout)
+{
+    if (size < AT45_ASYNC_MIN_SIZE)
+        AT45_PollingTransfer(AT45_Handle, pTX, pRX, size, timeout);
+    else if (pRX == NULL)
+        AT45_SPI_Transmit_DMA(AT45_Handle->hspix, (uint8_t *) pTX, size, timeout);
+    else
+        AT45_SPI_Receive_DMA(AT45_Handle->hspix, pRX, size, timeout);
+}
+
+static bool AT45_DMASubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size)
+{
+    if (pRX == NULL)
+        AT45_SPI_Transmit_DMA(AT45_Handle->hspix, (uint8_t *) pTX, size, 0);
+    else
+        AT45_SPI_Receive_DMA(AT45_Handle->hspix, pRX, size, 0);
+
+    return true;
+}
+
+static void AT45_ITTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                            uint32_t timeout)
+{
+    if (size < AT45_ASYNC_MIN_SIZE)
+        AT45_PollingTransfer(AT45_Handle, pTX, pRX, size, timeout);
+    else if (pRX == NULL)
+        AT45_SPI_Transmit_IT(AT45_Handle->hspix, (uint8_t *) pTX, size, timeout);
+    else
+        AT45_SPI_Receive_IT(AT45_Handle->hspix, pRX, size, timeout);
+}
+
+static bool AT45_ITSubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size)
+{
+    if (pRX == NULL)
+        AT45_SPI_Transmit_IT(AT45_Handle->hspix, (uint8_t *) pTX, size, 0);
+    else
+        AT45_SPI_Receive_IT(AT45_Handle->hspix, pRX, size, 0);
+
+    return true;
+}
+
+static bool AT45_AsyncComplete(AT45_HandleTypeDef *AT45_Handle)
+{
+    return AT45_SPI_Pending[AT45_SPI_Index(AT45_Handle->hspix)] != AT45_Handle->hspix;
+}
+
+static void AT45_AsyncAbort(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_SPI_Abort(AT45_Handle->hspix);
+}
+
+static uint8_t AT45_SPI_Index(SPI_HandleTypeDef *hspix)
+{
+    if (hspix->Instance == SPI1)
+        return 0;
+    if (hspix->Instance == SPI2)
+        return 1;
+
+    return 2;
+}
+
+static void AT45_SPI_WaitForCplt(SPI_HandleTypeDef *hspix, uint32_t timeout)
+{
+    uint32_t tickStart = uwTick;
+
+    while (AT45_SPI_Pending[AT45_SPI_Index(hspix)] == hspix)
+    {
+        if ((uwTick - tickStart) >= timeout)
+            Error_Handler();
+        AT45_SPI_Idle();
+    }
+}
+#endif
+
+#ifdef AT45_USE_HW_CRC
+static uint32_t AT45_CRC32Compute(const uint8_t *data, uint16_t dataLength)
+{
+    return AT45_CRC_Calculate(data, dataLength);
+}
+#endif
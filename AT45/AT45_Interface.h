@@ -6,8 +6,170 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* Transport options */
+// #define AT45_USE_ASYNC // DMA and interrupt transports, defines the SPI completion callbacks
+// #define AT45_USE_APP_SPI_CALLBACKS // The application defines the SPI completion callbacks and forwards them
+#define AT45_ASYNC_MIN_SIZE 16 // Shorter transfers (command, address, status) are polled
+
+/* Clock options */
+// #define AT45_USE_CLOCK_TUNING // AT45_Init probes the fastest reliable SPI clock of the device
+#define AT45_CLOCK_TUNING_MARGIN 1 // Prescaler steps below the fastest reliable clock
+
+/* Read options */
+// #define AT45_USE_PREFETCH // Sequential read-ahead of whole pages, enabled per device by AT45_PrefetchConfig
+// #define AT45_USE_CACHE // LRU cache of whole pages in front of AT45_Read, enabled per device by AT45_CacheConfig
+
+/* Checksum options */
+// #define AT45_USE_HW_CRC // CRC-32 of frames by the CRC calculation unit, selected per device by AT45_CRC32Checksum
+
+/* SPI_CR1_BR values */
+#define AT45_SPI_PRESCALER_STEP 0x0008 // Twice the divider
+#define AT45_SPI_PRESCALER_MAX  0x0038 // fPCLK/256
+
+struct AT45_HandleTypeDef_s;
+
+/* Transport operations, selected per device */
+typedef struct AT45_Ops_s
+{
+    /* Blocking transfer: pTX == NULL - dummy bytes are transmitted, pRX == NULL - received data is discarded */
+    void (*transfer)(struct AT45_HandleTypeDef_s *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                     uint32_t timeout);
+    void (*select)(struct AT45_HandleTypeDef_s *AT45_Handle);
+    void (*deselect)(struct AT45_HandleTypeDef_s *AT45_Handle);
+    void (*delay)(uint32_t ms);
+    uint32_t (*tick)(void);
+    /* Optional non-blocking transfer in one direction, NULL if not supported */
+    bool (*submit)(struct AT45_HandleTypeDef_s *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size);
+    bool (*complete)(struct AT45_HandleTypeDef_s *AT45_Handle);
+    /* Stops the submitted transfer before its completion, NULL if nothing can be left running */
+    void (*abort)(struct AT45_HandleTypeDef_s *AT45_Handle);
+} AT45_Ops_t;
+
+/* Frame checksum algorithm, selected per device */
+typedef struct AT45_Checksum_s
+{
+    uint8_t size; // Trailer length [bytes], the checksum is stored little-endian
+    uint32_t (*compute)(const uint8_t *data, uint16_t dataLength);
+} AT45_Checksum_t;
+
+/* Predefined transports */
+extern const AT45_Ops_t AT45_PollingOps;
+#ifdef AT45_USE_ASYNC
+extern const AT45_Ops_t AT45_DMAOps;
+extern const AT45_Ops_t AT45_ITOps;
+#endif
+#ifdef AT45_USE_HW_CRC
+extern const AT45_Checksum_t AT45_CRC32Checksum;
+#endif
+
 void AT45_SPI_Transmit(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
 void AT45_SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
 void AT45_Delay(uint32_t ms);
+uint32_t AT45_GetTick(void);
+
+/**
+ * @brief Gets the baud rate prescaler, SPI is currently configured with
+ * @param hspix: pointer to target SPI handle
+ * @return SPI_CR1_BR bits value
+ */
+uint16_t AT45_SPI_GetPrescaler(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Reconfigures the baud rate prescaler, if it differs from the current one
+ * @param hspix: pointer to target SPI handle
+ * @param prescaler: SPI_CR1_BR bits value
+ * @note Has to be called while there is no transfer in progress
+ */
+void AT45_SPI_SetPrescaler(SPI_HandleTypeDef *hspix, uint16_t prescaler);
+
+/**
+ * @brief Calculates SCK frequency, the prescaler results in
+ * @param hspix: pointer to target SPI handle
+ * @param prescaler: SPI_CR1_BR bits value
+ * @return SCK frequency [Hz]
+ */
+uint32_t AT45_SPI_GetClock(SPI_HandleTypeDef *hspix, uint16_t prescaler);
+
+#ifdef AT45_USE_HW_CRC
+/**
+ * @brief Calculates CRC-32 (poly 0x04C11DB7, init 0xFFFFFFFF) with the CRC calculation unit
+ * @param pData: pointer to data
+ * @param size: number of bytes
+ * @return CRC-32 value
+ * @note Data is fed by little-endian 32-bit words, the incomplete last word is padded with zeros
+ */
+uint32_t AT45_CRC_Calculate(const uint8_t *pData, uint16_t size);
+#endif
+
+#ifdef AT45_USE_ASYNC
+/**
+ * @brief Transmits data with DMA and waits for the end of transfer
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @param timeout: timeout duration [ms], 0 - returns right after the start
+ * @note The CPU runs AT45_SPI_Idle() while the transfer is in progress
+ */
+void AT45_SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Receives data with DMA and waits for the end of transfer
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @param timeout: timeout duration [ms], 0 - returns right after the start
+ * @note The CPU runs AT45_SPI_Idle() while the transfer is in progress
+ */
+void AT45_SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Transmits data with interrupt and waits for the end of transfer
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @param timeout: timeout duration [ms], 0 - returns right after the start
+ * @note The CPU runs AT45_SPI_Idle() between the interrupts
+ */
+void AT45_SPI_Transmit_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Receives data with interrupt and waits for the end of transfer
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @param timeout: timeout duration [ms], 0 - returns right after the start
+ * @note The CPU runs AT45_SPI_Idle() between the interrupts
+ */
+void AT45_SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Stops the DMA or interrupt transfer in progress, its completion is not signalled anymore
+ * @param hspix: pointer to target SPI handle
+ */
+void AT45_SPI_Abort(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Signals the end of transfer, has to be called from the SPI/DMA completion interrupt
+ * @param hspix: pointer to target SPI handle
+ * @note Called by HAL_SPI_TxCpltCallback()/RxCpltCallback()/TxRxCpltCallback() or SPI_TxRxCpltCallback() of the driver.
+ *       With AT45_USE_APP_SPI_CALLBACKS the application defines them and has to forward them here. Handles without
+ *       a transfer of the driver in progress are ignored
+ */
+void AT45_SPI_TransferCplt(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Signals a transfer error, calls Error_Handler() if the driver has a transfer in progress on the handle
+ * @param hspix: pointer to target SPI handle
+ * @note Called by HAL_SPI_ErrorCallback() of the driver, with AT45_USE_APP_SPI_CALLBACKS the application has to
+ *       forward it here
+ */
+void AT45_SPI_TransferError(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Background work hook, called repeatedly while DMA or interrupt transfer is in progress
+ * @note May be redefined in user code
+ */
+void AT45_SPI_Idle(void);
+#endif
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,60 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "AT45.h"
+#include <stdbool.h>
+
+/* Definitions */
+#define BENCHMARK_REPETITIONS    8 // Per operation and prescaler
+#define BENCHMARK_USE_CHIP_ERASE 1 // 0 - skip chip erase, which takes up to 40 s per prescaler
+#define BENCHMARK_PRESCALERS     8 // SPI_BAUDRATEPRESCALER_2...256
+#define BENCHMARK_FIRST_PAGE     3840 // First page of sector 15, the benchmark overwrites it
+#define BENCHMARK_DATA_LENGTH    (AT45_PAGE_SIZE - 2) // Trailing CRC fits the page
+
+typedef enum BenchmarkOperation_e {
+    BENCHMARK_INIT,
+    BENCHMARK_READ, // Whole page
+    BENCHMARK_READ_CRC,
+    BENCHMARK_WRITE_NO, // With CRC and page erase
+    BENCHMARK_WRITE_DELAY,
+    BENCHMARK_WRITE_BUSY,
+    BENCHMARK_PAGE_ERASE, // AT45_WAIT_BUSY
+    BENCHMARK_BLOCK_ERASE,
+    BENCHMARK_SECTOR_ERASE,
+    BENCHMARK_CHIP_ERASE,
+    BENCHMARK_OPERATIONS
+} BenchmarkOperation_t;
+
+/* CPU cycles */
+typedef struct BenchmarkResult_s
+{
+    uint64_t min;
+    uint64_t avg;
+    uint64_t max;
+    uint32_t count;
+    uint32_t errors; // Operations, that haven't returned AT45_STATUS_READY
+} BenchmarkResult_t;
+
+/* Results table, that is read over SWD */
+typedef struct BenchmarkTable_s
+{
+    uint32_t coreClock; // [Hz]
+    uint32_t sckClock[BENCHMARK_PRESCALERS]; // [Hz]
+    BenchmarkResult_t results[BENCHMARK_PRESCALERS][BENCHMARK_OPERATIONS];
+    volatile bool done;
+} BenchmarkTable_t;
+
+extern BenchmarkTable_t benchmarkTable;
+
+/**
+ * @brief Times the library operations with DWT cycle counter for every SPI prescaler
+ * @param AT45_Handle: pointer to the device handle structure
+ * @param hspix: pointer to target SPI handle
+ * @param CS_Port: GPIOx
+ * @param CS_Pin: GPIO_Pin_x
+ * @note Memory content is destroyed, benchmarkTable.done is set at the end
+ */
+void Benchmark_Run(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspix, GPIO_TypeDef *CS_Port,
+                   uint16_t CS_Pin);
+
+#endif
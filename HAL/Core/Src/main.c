@@ -18,12 +18,14 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "gpio.h"
 #include "spi.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "AT45.h"
+#include "benchmark.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -92,8 +94,12 @@ int main(void)
 
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_SPI3_Init();
     /* USER CODE BEGIN 2 */
+#ifdef AT45_BENCHMARK
+    Benchmark_Run(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin);
+#else
     AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin);
     if (AT45_Handle.status == AT45_STATUS_READY)
     {
@@ -108,10 +114,9 @@ int main(void)
         {
             printf("Data doesn't exist at page %i boundaries \r\n", PAGE);
             printf("Page programming...");
-            AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), PAGE_ADDRESS, true, false, AT45_WAIT_BUSY);
-            printf("\r\n Second approach to read \r\n");
-            AT45_Read(&AT45_Handle, bufferRead, sizeof(bufferRead), PAGE_ADDRESS, true);
-            if (memcmp(bufferRead, bufferWrite, sizeof(bufferRead)) == 0)
+            AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), PAGE_ADDRESS, true, false, AT45_WAIT_VERIFY);
+            printf("\r\n On-chip verify \r\n");
+            if (AT45_Handle.status == AT45_STATUS_READY)
             {
                 printf("Writing process success \r\n");
             }
@@ -127,6 +132,7 @@ int main(void)
         printf("Couldn't get any response from device \r\n");
         Error_Handler();
     }
+#endif
     /* USER CODE END 2 */
 
     /* Infinite loop */
@@ -0,0 +1,421 @@
+/* AT45_Read/AT45_Write/AT45_Erase sweeps on the virtual clock with CSV or JSON output */
+#include "init.h"
+#include "AT45.h"
+#include <getopt.h>
+#include <stdio.h>
+
+#define BENCH_SEED 0x2545F491
+
+typedef enum { BENCH_READ, BENCH_WRITE, BENCH_ERASE, BENCH_READ_STREAM, BENCH_WRITE_STREAM } BenchOperation_t;
+typedef enum { BENCH_CSV, BENCH_JSON } BenchFormat_t;
+
+typedef struct
+{
+    BenchOperation_t operation;
+    uint32_t size; // Payload or erase granularity
+    bool trailingCRC;
+    bool pageErase;
+    AT45_WaitForTask_t waitForTask;
+    AT45_EraseInstruction_t eraseInstruction;
+    bool randomAddress;
+} BenchPoint_t;
+
+typedef struct
+{
+    uint32_t ops;
+    uint32_t errors;
+    double elapsedSeconds;
+    double opsPerSecond;
+    double megabytesPerSecond;
+    double busBytesPerOp;
+    double selectsPerOp;
+    double statusPollsPerOp;
+    double heapAllocsPerOp;
+} BenchResult_t;
+
+/* Bench configuration */
+static BenchFormat_t format = BENCH_CSV;
+static AT45_SimTiming_t timing = AT45_SIM_TIMING_TYPICAL;
+static uint16_t prescaler = SPI_BaudRatePrescaler_16;
+static uint32_t opsPerPoint = 32;
+static uint32_t seed = BENCH_SEED;
+
+static AT45_HandleTypeDef AT45_Handle;
+static uint8_t buffer[AT45_BLOCK_SIZE * 16];
+static uint32_t heapAllocs;
+static bool firstRecord = true;
+
+static const uint16_t payloadSizes[] = {1, 2, 16, 64, 128, 256, 510, 512};
+static const uint32_t streamSizes[] = {AT45_PAGE_SIZE, AT45_BLOCK_SIZE, AT45_BLOCK_SIZE * 16};
+static const char *const timingNames[] = {"instant", "typical", "max", "random"};
+static const char *const waitNames[] = {"no", "delay", "busy", "verify"};
+static const char *const eraseNames[] = {"page", "block", "sector", "chip"};
+static const char *const operationNames[] = {"read", "write", "erase", "read_stream", "write_stream"};
+
+/* Heap allocations are counted by linking with --wrap=malloc,--wrap=calloc,--wrap=realloc */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    heapAllocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    heapAllocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    heapAllocs++;
+    return __real_realloc(ptr, size);
+}
+
+static uint32_t Bench_Random(void)
+{
+    /* xorshift32 */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return seed;
+}
+
+static uint32_t Bench_Address(const BenchPoint_t *point, uint32_t index)
+{
+    uint32_t unitSize = AT45_PAGE_SIZE;
+    uint32_t units;
+
+    if (point->operation == BENCH_ERASE)
+    {
+        if (point->eraseInstruction == AT45_BLOCK_ERASE)
+            unitSize = AT45_BLOCK_SIZE;
+        else if (point->eraseInstruction == AT45_SECTOR_ERASE)
+            unitSize = AT45_SECTOR_SIZE;
+        else if (point->eraseInstruction == AT45_CHIP_ERASE)
+            return 0;
+    }
+    else if ((point->operation == BENCH_READ_STREAM) || (point->operation == BENCH_WRITE_STREAM))
+    {
+        /* Byte granular, any window that fits in the array */
+        units = AT45_PAGE_SIZE * AT45_Handle.numberOfPages - point->size + 1;
+
+        return point->randomAddress ? (Bench_Random() % units) : ((index * point->size) % units);
+    }
+    units = (AT45_PAGE_SIZE * AT45_Handle.numberOfPages) / unitSize;
+
+    return ((point->randomAddress ? Bench_Random() : index) % units) * unitSize;
+}
+
+static BenchResult_t Bench_Run(const BenchPoint_t *point)
+{
+    BenchResult_t result = {0};
+    uint32_t selectCount, statusPollCount;
+    uint64_t byteCount, start, bytes = 0;
+    AT45_Status_t status;
+    uint32_t i, address;
+
+    /* Fresh device for every point */
+    if (AT45_Sim_Init(&AT45_Sim0, NULL) != SUCCESS)
+        Error_Handler();
+    SPIx_Init(&hspi3, SPI_Mode_Master, prescaler);
+    memset(&AT45_Handle, 0, sizeof(AT45_Handle));
+    AT45_Handle.ops = &AT45_SimOps;
+    if (AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin) != AT45_STATUS_READY)
+        Error_Handler();
+    AT45_Sim_SetTiming(&AT45_Sim0, timing, BENCH_SEED);
+    seed = BENCH_SEED;
+
+    /* Chip erase is too long to be repeated */
+    result.ops = ((point->operation == BENCH_ERASE) && (point->eraseInstruction == AT45_CHIP_ERASE)) ? 1 : opsPerPoint;
+
+    selectCount = AT45_Sim0.selectCount;
+    byteCount = AT45_Sim0.byteCount;
+    statusPollCount = AT45_Sim0.statusPollCount;
+    heapAllocs = 0;
+    start = Time_Get();
+    for (i = 0; i < result.ops; i++)
+    {
+        address = Bench_Address(point, i);
+        switch (point->operation)
+        {
+        case BENCH_READ:
+            status = AT45_Read(&AT45_Handle, buffer, (uint16_t) point->size, address, point->trailingCRC);
+            bytes += point->size;
+            break;
+
+        case BENCH_READ_STREAM:
+            status = AT45_ReadStream(&AT45_Handle, buffer, point->size, address);
+            bytes += point->size;
+            break;
+
+        case BENCH_WRITE:
+            memset(buffer, (uint8_t) i, point->size);
+            status = AT45_Write(&AT45_Handle, buffer, (uint16_t) point->size, address, point->trailingCRC,
+                                point->pageErase, point->waitForTask);
+            bytes += point->size;
+            break;
+
+        case BENCH_WRITE_STREAM:
+            memset(buffer, (uint8_t) i, point->size);
+            status = AT45_WriteStream(&AT45_Handle, buffer, point->size, address, point->trailingCRC,
+                                      point->pageErase, point->waitForTask);
+            bytes += point->size;
+            break;
+
+        default:
+            status = AT45_Erase(&AT45_Handle, point->eraseInstruction, address, point->waitForTask);
+            bytes += (point->eraseInstruction == AT45_CHIP_ERASE) ? (AT45_PAGE_SIZE * AT45_Handle.numberOfPages)
+                                                                   : point->size;
+            break;
+        }
+        /* Erased pages hold no CRC */
+        if ((status != AT45_STATUS_READY) &&
+            !((point->operation == BENCH_READ) && (status == AT45_STATUS_ERROR_CHECKSUM)))
+            result.errors++;
+    }
+    result.elapsedSeconds = (double) (Time_Get() - start) / (TIME_PS_PER_MS * 1000);
+
+    result.opsPerSecond = result.ops / result.elapsedSeconds;
+    result.megabytesPerSecond = bytes / result.elapsedSeconds / 1e6;
+    result.busBytesPerOp = (double) (AT45_Sim0.byteCount - byteCount) / result.ops;
+    result.selectsPerOp = (double) (AT45_Sim0.selectCount - selectCount) / result.ops;
+    result.statusPollsPerOp = (double) (AT45_Sim0.statusPollCount - statusPollCount) / result.ops;
+    result.heapAllocsPerOp = (double) heapAllocs / result.ops;
+
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    return result;
+}
+
+static void Bench_Print(const BenchPoint_t *point, const BenchResult_t *result)
+{
+    const char *crc = ((point->operation == BENCH_ERASE) || (point->operation == BENCH_READ_STREAM))
+                          ? ""
+                          : (point->trailingCRC ? "1" : "0");
+    const char *erase = ((point->operation == BENCH_WRITE) || (point->operation == BENCH_WRITE_STREAM))
+                            ? (point->pageErase ? "1" : "0")
+                            : "";
+    const char *wait = ((point->operation == BENCH_READ) || (point->operation == BENCH_READ_STREAM))
+                           ? ""
+                           : waitNames[point->waitForTask];
+    const char *granularity = (point->operation == BENCH_ERASE) ? eraseNames[point->eraseInstruction] : "";
+    const char *addressing = point->randomAddress ? "random" : "sequential";
+
+    if (format == BENCH_CSV)
+    {
+        if (firstRecord)
+            printf("operation,size,crc,page_erase,wait,granularity,addressing,ops,errors,elapsed_s,ops_per_s,"
+                   "mb_per_s,bus_bytes_per_op,cs_per_op,status_polls_per_op,heap_allocs_per_op\n");
+        printf("%s,%u,%s,%s,%s,%s,%s,%u,%u,%.6f,%.3f,%.6f,%.2f,%.2f,%.2f,%.2f\n", operationNames[point->operation],
+               (unsigned) point->size, crc, erase, wait, granularity, addressing, (unsigned) result->ops,
+               (unsigned) result->errors, result->elapsedSeconds, result->opsPerSecond, result->megabytesPerSecond,
+               result->busBytesPerOp, result->selectsPerOp, result->statusPollsPerOp, result->heapAllocsPerOp);
+    }
+    else
+    {
+        printf("%s\n    {\"operation\": \"%s\", \"size\": %u, \"crc\": \"%s\", \"page_erase\": \"%s\", "
+               "\"wait\": \"%s\", \"granularity\": \"%s\", \"addressing\": \"%s\", \"ops\": %u, \"errors\": %u, "
+               "\"elapsed_s\": %.6f, \"ops_per_s\": %.3f, \"mb_per_s\": %.6f, \"bus_bytes_per_op\": %.2f, "
+               "\"cs_per_op\": %.2f, \"status_polls_per_op\": %.2f, \"heap_allocs_per_op\": %.2f}",
+               firstRecord ? "" : ",", operationNames[point->operation], (unsigned) point->size, crc, erase, wait,
+               granularity, addressing, (unsigned) result->ops, (unsigned) result->errors, result->elapsedSeconds,
+               result->opsPerSecond, result->megabytesPerSecond, result->busBytesPerOp, result->selectsPerOp,
+               result->statusPollsPerOp, result->heapAllocsPerOp);
+    }
+    firstRecord = false;
+}
+
+static void Bench_Point(const BenchPoint_t *point)
+{
+    BenchResult_t result = Bench_Run(point);
+
+    Bench_Print(point, &result);
+}
+
+static void Bench_Sweep(void)
+{
+    static const AT45_WaitForTask_t waits[] = {AT45_WAIT_NO, AT45_WAIT_DELAY, AT45_WAIT_BUSY};
+    static const AT45_WaitForTask_t writeWaits[] = {AT45_WAIT_NO, AT45_WAIT_DELAY, AT45_WAIT_BUSY, AT45_WAIT_VERIFY};
+    static const struct
+    {
+        AT45_EraseInstruction_t instruction;
+        uint32_t size;
+    } erases[] = {{AT45_PAGE_ERASE, AT45_PAGE_SIZE},
+                  {AT45_BLOCK_ERASE, AT45_BLOCK_SIZE},
+                  {AT45_SECTOR_ERASE, AT45_SECTOR_SIZE},
+                  {AT45_CHIP_ERASE, 0}};
+    BenchPoint_t point = {0};
+    size_t s, w, e;
+    int crc, pageErase, randomAddress;
+
+    for (randomAddress = 0; randomAddress <= 1; randomAddress++)
+    {
+        point.randomAddress = randomAddress;
+
+        /* Read */
+        point.operation = BENCH_READ;
+        for (crc = 0; crc <= 1; crc++)
+        {
+            for (s = 0; s < sizeof(payloadSizes) / sizeof(payloadSizes[0]); s++)
+            {
+                if (payloadSizes[s] + (crc ? sizeof(uint16_t) : 0) > AT45_PAGE_SIZE)
+                    continue;
+                point.trailingCRC = crc;
+                point.size = payloadSizes[s];
+                Bench_Point(&point);
+            }
+        }
+
+        /* Continuous read across page boundaries */
+        point.operation = BENCH_READ_STREAM;
+        point.trailingCRC = false;
+        for (s = 0; s < sizeof(streamSizes) / sizeof(streamSizes[0]); s++)
+        {
+            point.size = streamSizes[s];
+            Bench_Point(&point);
+        }
+
+        /* Write across page boundaries, one frame per page */
+        point.operation = BENCH_WRITE_STREAM;
+        point.pageErase = true;
+        for (crc = 0; crc <= 1; crc++)
+        {
+            for (w = 0; w < sizeof(writeWaits) / sizeof(writeWaits[0]); w++)
+            {
+                for (s = 0; s < sizeof(streamSizes) / sizeof(streamSizes[0]); s++)
+                {
+                    point.trailingCRC = crc;
+                    point.waitForTask = writeWaits[w];
+                    point.size = streamSizes[s];
+                    Bench_Point(&point);
+                }
+            }
+        }
+
+        /* Write */
+        point.operation = BENCH_WRITE;
+        for (crc = 0; crc <= 1; crc++)
+        {
+            for (pageErase = 0; pageErase <= 1; pageErase++)
+            {
+                for (w = 0; w < sizeof(writeWaits) / sizeof(writeWaits[0]); w++)
+                {
+                    /* Programming without erase only clears bits, the page does not match the written data */
+                    if ((writeWaits[w] == AT45_WAIT_VERIFY) && !pageErase)
+                        continue;
+                    for (s = 0; s < sizeof(payloadSizes) / sizeof(payloadSizes[0]); s++)
+                    {
+                        if (payloadSizes[s] + (crc ? sizeof(uint16_t) : 0) > AT45_PAGE_SIZE)
+                            continue;
+                        point.trailingCRC = crc;
+                        point.pageErase = pageErase;
+                        point.waitForTask = writeWaits[w];
+                        point.size = payloadSizes[s];
+                        Bench_Point(&point);
+                    }
+                }
+            }
+        }
+
+        /* Erase */
+        point.operation = BENCH_ERASE;
+        for (e = 0; e < sizeof(erases) / sizeof(erases[0]); e++)
+        {
+            /* Single address */
+            if ((erases[e].instruction == AT45_CHIP_ERASE) && randomAddress)
+                continue;
+            for (w = 0; w < sizeof(waits) / sizeof(waits[0]); w++)
+            {
+                point.eraseInstruction = erases[e].instruction;
+                point.waitForTask = waits[w];
+                point.size = erases[e].size;
+                Bench_Point(&point);
+            }
+        }
+    }
+}
+
+static void Bench_Usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-f csv|json] [-t instant|typical|max|random] [-p 2|4|8|16|32|64|128|256] [-n ops]\n"
+            "  -f  output format (csv)\n"
+            "  -t  program/erase duration model (typical)\n"
+            "  -p  SPI3 baud rate prescaler (16)\n"
+            "  -n  operations per point (32)\n",
+            name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long divider;
+    int option;
+    size_t t;
+
+    while ((option = getopt(argc, argv, "f:t:p:n:")) != -1)
+    {
+        switch (option)
+        {
+        case 'f':
+            if (strcmp(optarg, "csv") == 0)
+                format = BENCH_CSV;
+            else if (strcmp(optarg, "json") == 0)
+                format = BENCH_JSON;
+            else
+                Bench_Usage(argv[0]);
+            break;
+
+        case 't':
+            for (t = 0; t < sizeof(timingNames) / sizeof(timingNames[0]); t++)
+            {
+                if (strcmp(optarg, timingNames[t]) == 0)
+                    break;
+            }
+            if (t == sizeof(timingNames) / sizeof(timingNames[0]))
+                Bench_Usage(argv[0]);
+            timing = (AT45_SimTiming_t) t;
+            break;
+
+        case 'p':
+            divider = strtoul(optarg, NULL, 0);
+            if ((divider < 2) || (divider > 256) || (divider & (divider - 1)))
+                Bench_Usage(argv[0]);
+            prescaler = (uint16_t) ((__builtin_ctzl(divider) - 1) << 3); // BR[2:0] of CR1
+            break;
+
+        case 'n':
+            opsPerPoint = strtoul(optarg, NULL, 0);
+            if (opsPerPoint == 0)
+                Bench_Usage(argv[0]);
+            break;
+
+        default:
+            Bench_Usage(argv[0]);
+        }
+    }
+
+    /* Board wiring, the device itself is powered up for every point */
+    IO_Init(NULL);
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    if (format == BENCH_JSON)
+        printf("{\n  \"timing\": \"%s\",\n  \"sck_hz\": %lu,\n  \"ops_per_point\": %u,\n  \"points\": [",
+               timingNames[timing], APB1_CLOCK / (2ul << (prescaler >> 3)), (unsigned) opsPerPoint);
+    Bench_Sweep();
+    if (format == BENCH_JSON)
+        printf("\n  ]\n}\n");
+
+    return 0;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler() has been called \r\n");
+    abort();
+}
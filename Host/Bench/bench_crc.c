@@ -0,0 +1,94 @@
+/* Checksum engines on page-sized frames, wall clock of the host CPU */
+#include "AT45.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_FRAMES      256
+#define BENCH_ROUNDS      64
+#define BENCH_DATA_LENGTH (AT45_PAGE_SIZE - 2) // ModBus CRC16 fills the page
+
+typedef struct
+{
+    const char *name;
+    const AT45_Checksum_t *checksum;
+} BenchEngine_t;
+
+static uint8_t frames[BENCH_FRAMES][BENCH_DATA_LENGTH];
+static volatile uint32_t sink; // Keeps the results alive
+
+static double Bench_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+static double Bench_Run(const AT45_Checksum_t *checksum)
+{
+    double start = Bench_Now();
+    uint32_t round, frame;
+
+    for (round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (frame = 0; frame < BENCH_FRAMES; frame++)
+            sink = checksum->compute(frames[frame], sizeof(frames[frame]));
+    }
+
+    return (Bench_Now() - start) / (BENCH_ROUNDS * BENCH_FRAMES);
+}
+
+int main(void)
+{
+    static const BenchEngine_t engines[] = {{"modbus-bitwise", &AT45_ModBusBitwiseChecksum},
+                                            {"modbus-table", &AT45_ModBusChecksum}};
+    uint32_t seed = 0xA5A5A5A5;
+    uint32_t frame, i;
+    uint32_t mismatches = 0;
+    double reference = 0.0;
+    double perFrame;
+    size_t e;
+
+    for (frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        for (i = 0; i < sizeof(frames[frame]); i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            frames[frame][i] = (uint8_t) seed;
+        }
+    }
+
+    /* Existing data has to stay readable: every engine of the same CRC matches the bitwise one */
+    for (frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        for (i = 1; i <= sizeof(frames[frame]); i += 37)
+        {
+            if (AT45_ModBusChecksum.compute(frames[frame], (uint16_t) i) !=
+                AT45_ModBusBitwiseChecksum.compute(frames[frame], (uint16_t) i))
+                mismatches++;
+        }
+    }
+
+    printf("Checksum of %u-byte frames, %u frames x %u rounds, mismatches with bitwise: %u\n",
+           (unsigned) BENCH_DATA_LENGTH, (unsigned) BENCH_FRAMES, (unsigned) BENCH_ROUNDS, (unsigned) mismatches);
+    printf("%-16s %7s %12s %10s %8s\n", "engine", "trailer", "ns/frame", "MB/s", "speedup");
+    for (e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+    {
+        perFrame = Bench_Run(engines[e].checksum);
+        if (e == 0)
+            reference = perFrame;
+        printf("%-16s %7u %12.1f %10.1f %7.2fx\n", engines[e].name, (unsigned) engines[e].checksum->size,
+               perFrame * 1e9, BENCH_DATA_LENGTH / perFrame / 1e6, reference / perFrame);
+    }
+
+    return (mismatches == 0) ? 0 : 1;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler() has been called \r\n");
+    abort();
+}
@@ -0,0 +1,125 @@
+/* AT45_Write latency with AT45_WAIT_BUSY versus AT45_WAIT_DELAY on the virtual clock */
+#include "init.h"
+#include "AT45.h"
+#include <stdio.h>
+
+#define BENCH_PAGES       64
+#define BENCH_FIRST_PAGE  1024
+#define BENCH_DATA_LENGTH (AT45_PAGE_SIZE - 2) // Trailing CRC fits the page
+
+typedef struct
+{
+    double min;
+    double avg;
+    double max;
+    uint32_t timeouts;
+    uint32_t mismatches;
+} BenchResult_t;
+
+static const struct
+{
+    uint16_t value;
+    uint16_t divider;
+} prescalers[] = {{SPI_BaudRatePrescaler_2, 2}, {SPI_BaudRatePrescaler_16, 16}, {SPI_BaudRatePrescaler_256, 256}};
+
+static const char *const timingNames[] = {"instant", "typical", "max", "random"};
+
+static AT45_HandleTypeDef AT45_Handle;
+static uint8_t bufferWrite[BENCH_DATA_LENGTH];
+static uint8_t bufferRead[BENCH_DATA_LENGTH];
+
+static BenchResult_t Bench_Run(uint16_t prescaler, AT45_SimTiming_t timing, bool pageErase,
+                               AT45_WaitForTask_t waitForTask)
+{
+    BenchResult_t result = {.min = 1e30};
+    uint64_t start;
+    double latency;
+    uint32_t page, i;
+
+    /* Fresh device for every point, so programming without erase lands on erased pages */
+    if (AT45_Sim_Init(&AT45_Sim0, NULL) != SUCCESS)
+        Error_Handler();
+    SPIx_Init(&hspi3, SPI_Mode_Master, prescaler);
+    memset(&AT45_Handle, 0, sizeof(AT45_Handle));
+    AT45_Handle.ops = &AT45_SimOps;
+    if (AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin) != AT45_STATUS_READY)
+        Error_Handler();
+    AT45_Sim_SetTiming(&AT45_Sim0, timing, 0xA5A5A5A5);
+
+    for (page = BENCH_FIRST_PAGE; page < (BENCH_FIRST_PAGE + BENCH_PAGES); page++)
+    {
+        for (i = 0; i < sizeof(bufferWrite); i++)
+            bufferWrite[i] = (uint8_t) (page + i);
+
+        start = Time_Get();
+        if (AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), page * AT45_PAGE_SIZE, true, pageErase,
+                       waitForTask) == AT45_STATUS_ERROR_TIMEOUT)
+            result.timeouts++;
+        latency = (double) (Time_Get() - start) / TIME_PS_PER_MS;
+
+        result.avg += latency;
+        if (latency < result.min)
+            result.min = latency;
+        if (latency > result.max)
+            result.max = latency;
+    }
+    result.avg /= BENCH_PAGES;
+
+    /* Read back, the device may still be busy after AT45_WAIT_DELAY */
+    for (page = BENCH_FIRST_PAGE; page < (BENCH_FIRST_PAGE + BENCH_PAGES); page++)
+    {
+        for (i = 0; i < sizeof(bufferWrite); i++)
+            bufferWrite[i] = (uint8_t) (page + i);
+        if ((AT45_Read(&AT45_Handle, bufferRead, sizeof(bufferRead), page * AT45_PAGE_SIZE, true) !=
+             AT45_STATUS_READY) ||
+            (memcmp(bufferRead, bufferWrite, sizeof(bufferRead)) != 0))
+            result.mismatches++;
+    }
+
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    return result;
+}
+
+int main(void)
+{
+    static const AT45_SimTiming_t timings[] = {AT45_SIM_TIMING_TYPICAL, AT45_SIM_TIMING_MAX, AT45_SIM_TIMING_RANDOM};
+    static const AT45_WaitForTask_t waits[] = {AT45_WAIT_DELAY, AT45_WAIT_BUSY};
+    BenchResult_t result;
+    size_t p, t, w;
+    int pageErase;
+
+    /* Board wiring, the device itself is powered up for every point */
+    IO_Init(NULL);
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    printf("AT45_Write of %u bytes + CRC to %u pages, SPI3 at %lu MHz bus clock, latency [ms]\n",
+           (unsigned) BENCH_DATA_LENGTH, (unsigned) BENCH_PAGES, APB1_CLOCK / 1000000);
+    printf("%-8s %-8s %-6s %-6s %9s %9s %9s %8s %10s\n", "SCK", "timing", "erase", "wait", "min", "avg", "max",
+           "timeouts", "mismatches");
+    for (p = 0; p < sizeof(prescalers) / sizeof(prescalers[0]); p++)
+    {
+        for (t = 0; t < sizeof(timings) / sizeof(timings[0]); t++)
+        {
+            for (pageErase = 0; pageErase <= 1; pageErase++)
+            {
+                for (w = 0; w < sizeof(waits) / sizeof(waits[0]); w++)
+                {
+                    result = Bench_Run(prescalers[p].value, timings[t], pageErase, waits[w]);
+                    printf("%5lukHz %-8s %-6s %-6s %9.3f %9.3f %9.3f %8u %10u\n",
+                           APB1_CLOCK / prescalers[p].divider / 1000, timingNames[timings[t]],
+                           pageErase ? "yes" : "no", (waits[w] == AT45_WAIT_BUSY) ? "busy" : "delay", result.min,
+                           result.avg, result.max, (unsigned) result.timeouts, (unsigned) result.mismatches);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler() has been called \r\n");
+    abort();
+}
@@ -0,0 +1,61 @@
+#ifndef HOST_PERIPH_H
+#define HOST_PERIPH_H
+
+/* Minimal stand-ins for the CMSIS/SPL definitions used by the library */
+#include <stdint.h>
+
+#define __weak __attribute__((weak))
+
+#define SET_BIT(REG, BIT)   ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)  ((REG) & (BIT))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) ((REG) = (((REG) & ~(CLEARMASK)) | (SETMASK)))
+
+typedef enum { ERROR = 0, SUCCESS = !ERROR } ErrorStatus;
+
+/* GPIO port: every pin may carry a bus device, that is selected by the pin */
+typedef struct
+{
+    uint32_t BSRR;
+    void *device[16];
+} GPIO_TypeDef;
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t SR;
+    uint32_t DR;
+} SPI_TypeDef;
+
+#define SPI_CR1_BR  ((uint16_t) 0x0038)
+#define SPI_CR1_SPE ((uint16_t) 0x0040)
+
+extern SPI_TypeDef SPI1_Instance, SPI2_Instance, SPI3_Instance;
+#define SPI1 (&SPI1_Instance)
+#define SPI2 (&SPI2_Instance)
+#define SPI3 (&SPI3_Instance)
+
+extern GPIO_TypeDef GPIOD_Instance;
+#define GPIOD (&GPIOD_Instance)
+
+#define GPIO_Pin_0 ((uint16_t) 0x0001)
+#define GPIO_Pin_1 ((uint16_t) 0x0002)
+#define GPIO_Pin_2 ((uint16_t) 0x0004)
+
+/* Bus clocks of STM32F407 running at 168 MHz [Hz] */
+#define APB1_CLOCK 42000000UL // SPI2, SPI3
+#define APB2_CLOCK 84000000UL // SPI1
+
+/* SPL values */
+#define SPI_Mode_Master            ((uint16_t) 0x0104)
+#define SPI_Mode_Slave             ((uint16_t) 0x0000)
+#define SPI_BaudRatePrescaler_2    ((uint16_t) 0x0000)
+#define SPI_BaudRatePrescaler_4    ((uint16_t) 0x0008)
+#define SPI_BaudRatePrescaler_8    ((uint16_t) 0x0010)
+#define SPI_BaudRatePrescaler_16   ((uint16_t) 0x0018)
+#define SPI_BaudRatePrescaler_32   ((uint16_t) 0x0020)
+#define SPI_BaudRatePrescaler_64   ((uint16_t) 0x0028)
+#define SPI_BaudRatePrescaler_128  ((uint16_t) 0x0030)
+#define SPI_BaudRatePrescaler_256  ((uint16_t) 0x0038)
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef INIT_H
+#define INIT_H
+
+#include "AT45_Sim.h"
+#include "SPI.h"
+#include <stdio.h>
+
+#define CS0_Pin       GPIO_Pin_0
+#define CS0_GPIO_Port GPIOD
+
+extern SPI_HandleTypeDef hspi3;
+extern AT45_Sim_t AT45_Sim0;
+
+/**
+ * @brief Powers up the simulated device and wires it to CS0
+ * @param backingFile: path of the memory image, NULL - volatile memory
+ */
+void IO_Init(const char *backingFile);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "AT45.h"
+#include "init.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Definitions */
+#define PAGE         1408
+#define PAGE_ADDRESS (PAGE * AT45_PAGE_SIZE)
+
+void Error_Handler(void);
+
+#endif
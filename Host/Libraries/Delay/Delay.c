@@ -0,0 +1,23 @@
+#include "Delay.h"
+
+uint32_t uwTick = 0;
+
+/* The host has no notion of the target time: everything, that takes time on the target
+ * (SPI clocking, delays, self-timed operations of the devices) is charged to this clock */
+static uint64_t timePs = 0;
+
+void Delay(uint32_t ms)
+{
+    Time_Advance(ms * TIME_PS_PER_MS);
+}
+
+void Time_Advance(uint64_t ps)
+{
+    timePs += ps;
+    uwTick = (uint32_t) (timePs / TIME_PS_PER_MS);
+}
+
+uint64_t Time_Get(void)
+{
+    return timePs;
+}
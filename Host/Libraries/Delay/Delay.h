@@ -0,0 +1,34 @@
+#ifndef DELAY_H
+#define DELAY_H
+
+#include "host_periph.h"
+
+#define GLOBAL_TICK_FREQ 1 // 1 kHz
+
+/* Virtual time units */
+#define TIME_PS_PER_NS 1000ULL
+#define TIME_PS_PER_US 1000000ULL
+#define TIME_PS_PER_MS 1000000000ULL
+
+extern uint32_t uwTick;
+extern void Error_Handler(void);
+
+/**
+ * @brief Advances the virtual clock without sleeping
+ * @param ms: delay duration
+ */
+void Delay(uint32_t ms);
+
+/**
+ * @brief Advances the virtual clock, uwTick follows it
+ * @param ps: time interval [ps]
+ */
+void Time_Advance(uint64_t ps);
+
+/**
+ * @brief Gets the virtual clock
+ * @return Time since start [ps]
+ */
+uint64_t Time_Get(void);
+
+#endif
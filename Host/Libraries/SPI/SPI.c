@@ -0,0 +1,190 @@
+#include "SPI.h"
+
+/* Register blocks are only used as instance identifiers */
+SPI_TypeDef SPI1_Instance, SPI2_Instance, SPI3_Instance;
+
+static void SPI_Exchange(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size);
+static uint64_t SPI_ByteTime(const SPI_HandleTypeDef *hspix);
+static SPI_StateTypeDef SPI_Async(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                  SPI_StateTypeDef state);
+
+SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t SPI_BaudRatePrescaler)
+{
+    /* Prepare and reset the handle members */
+    hspix->sizeRX = 0;
+    hspix->sizeTX = 0;
+    hspix->countRX = 0;
+    hspix->countTX = 0;
+    hspix->pBuffRX = NULL;
+    hspix->pBuffTX = NULL;
+    hspix->frame16 = false;
+    hspix->device = NULL;
+    hspix->exchange = NULL;
+    hspix->state = SPI_STATE_RESET;
+
+    if ((hspix->Instance != SPI1) && (hspix->Instance != SPI2) && (hspix->Instance != SPI3))
+        return hspix->state; // No match for SPIx
+    if (SPI_Mode != SPI_Mode_Master)
+        return hspix->state;
+
+    hspix->Instance->CR1 = SPI_Mode | SPI_BaudRatePrescaler | SPI_CR1_SPE;
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+SPI_StateTypeDef SPI_BaudRateConfig(SPI_HandleTypeDef *hspix, uint16_t SPI_BaudRatePrescaler, uint32_t timeout)
+{
+    (void) timeout;
+
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    MODIFY_REG(hspix->Instance->CR1, SPI_CR1_BR, SPI_BaudRatePrescaler);
+
+    return hspix->state;
+}
+
+uint32_t SPI_GetBusClock(const SPI_HandleTypeDef *hspix)
+{
+    return (hspix->Instance == SPI1) ? APB2_CLOCK : APB1_CLOCK;
+}
+
+uint32_t SPI_GetClock(const SPI_HandleTypeDef *hspix)
+{
+    return SPI_GetBusClock(hspix) >> ((READ_BIT(hspix->Instance->CR1, SPI_CR1_BR) >> 3) + 1);
+}
+
+SPI_StateTypeDef SPI_Transmit(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    if (pData == NULL)
+        return hspix->state = SPI_STATE_ERROR;
+
+    return SPI_TransmitReceive(hspix, pData, NULL, size, timeout);
+}
+
+SPI_StateTypeDef SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout)
+{
+    if (pData == NULL)
+        return hspix->state = SPI_STATE_ERROR;
+
+    return SPI_TransmitReceive(hspix, NULL, pData, size, timeout);
+}
+
+SPI_StateTypeDef SPI_TransmitReceive(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                     uint32_t timeout)
+{
+    (void) timeout;
+
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if (size == 0)
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_TX_RX;
+    SPI_Exchange(hspix, pDataTX, pDataRX, size);
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+SPI_StateTypeDef SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size)
+{
+    return SPI_Async(hspix, pData, NULL, size, SPI_STATE_BUSY_TX);
+}
+
+SPI_StateTypeDef SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size)
+{
+    return SPI_Async(hspix, NULL, pData, size, SPI_STATE_BUSY_RX);
+}
+
+SPI_StateTypeDef SPI_Transmit_IT(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size)
+{
+    return SPI_Async(hspix, pData, NULL, size, SPI_STATE_BUSY_TX);
+}
+
+SPI_StateTypeDef SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size)
+{
+    return SPI_Async(hspix, NULL, pData, size, SPI_STATE_BUSY_RX);
+}
+
+SPI_StateTypeDef SPI_Abort(SPI_HandleTypeDef *hspix)
+{
+    if ((hspix->state != SPI_STATE_BUSY_TX) && (hspix->state != SPI_STATE_BUSY_RX))
+        return hspix->state;
+
+    /* Nothing has been clocked yet, the destination stays untouched */
+    hspix->pBuffTX = NULL;
+    hspix->pBuffRX = NULL;
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+void SPI_IRQHandler(SPI_HandleTypeDef *hspix)
+{
+    if ((hspix->state != SPI_STATE_BUSY_TX) && (hspix->state != SPI_STATE_BUSY_RX))
+        return;
+
+    /* The bus time of the whole transfer is charged here */
+    SPI_Exchange(hspix, hspix->pBuffTX, hspix->pBuffRX, hspix->sizeTX);
+    hspix->pBuffTX = NULL;
+    hspix->pBuffRX = NULL;
+    hspix->state = SPI_STATE_READY;
+    SPI_TxRxCpltCallback(hspix);
+}
+
+__weak void SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspix)
+{
+    /* May be redefined in user code */
+    (void) hspix;
+}
+
+/**
+ * @section Private functions
+ */
+static void SPI_Exchange(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size)
+{
+    uint64_t byteTime = SPI_ByteTime(hspix);
+    uint8_t data;
+
+    hspix->sizeTX = size;
+    hspix->sizeRX = size;
+    for (hspix->countTX = 0, hspix->countRX = 0; hspix->countRX < size;)
+    {
+        data = (pDataTX != NULL) ? pDataTX[hspix->countTX] : 0x00;
+        hspix->countTX++;
+
+        /* Floating MISO without selected device */
+        Time_Advance(byteTime);
+        data = (hspix->exchange != NULL) ? hspix->exchange(hspix->device, data) : 0xFF;
+        if (pDataRX != NULL)
+            pDataRX[hspix->countRX] = data;
+        hspix->countRX++;
+    }
+}
+
+static uint64_t SPI_ByteTime(const SPI_HandleTypeDef *hspix)
+{
+    uint32_t busClock = (hspix->Instance == SPI1) ? APB2_CLOCK : APB1_CLOCK;
+    uint32_t divider = 2u << (READ_BIT(hspix->Instance->CR1, SPI_CR1_BR) >> 3);
+
+    /* 8 SCK periods, back-to-back frames */
+    return 8 * divider * TIME_PS_PER_MS * 1000 / busClock;
+}
+
+static SPI_StateTypeDef SPI_Async(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                  SPI_StateTypeDef state)
+{
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if (((pDataTX == NULL) && (pDataRX == NULL)) || (size == 0))
+        return hspix->state = SPI_STATE_ERROR;
+
+    /* The transfer stays pending until SPI_IRQHandler() is serviced */
+    hspix->pBuffTX = (uint8_t *) pDataTX;
+    hspix->pBuffRX = pDataRX;
+    hspix->sizeTX = size;
+    hspix->sizeRX = size;
+
+    return hspix->state = state;
+}
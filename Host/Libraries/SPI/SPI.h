@@ -0,0 +1,150 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include "Delay.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define INFINITE_TIMEOUT 0
+
+typedef enum {
+    SPI_STATE_RESET = 0x00U, // Peripheral not Initialized
+    SPI_STATE_READY = 0x01U, // Peripheral Initialized and ready for use
+    SPI_STATE_BUSY = 0x02U, // An internal process is ongoing
+    SPI_STATE_BUSY_TX = 0x03U, // Data Transmission process is ongoing
+    SPI_STATE_BUSY_RX = 0x04U, // Data Reception process is ongoing
+    SPI_STATE_BUSY_TX_RX = 0x05U, // Data Transmission and Reception process is ongoing
+    SPI_STATE_ERROR = 0x06U, // SPI error state
+    SPI_STATE_ABORT = 0x07U // SPI abort is ongoing
+} SPI_StateTypeDef;
+
+typedef struct
+{
+    SPI_TypeDef *Instance;
+    uint16_t sizeRX;
+    uint16_t sizeTX;
+    uint16_t countRX;
+    uint16_t countTX;
+    uint8_t *pBuffRX;
+    uint8_t *pBuffTX;
+    bool frame16;
+    SPI_StateTypeDef state;
+    void *device; // Currently selected bus device
+    uint8_t (*exchange)(void *device, uint8_t data); // Full-duplex byte exchange with the selected device
+} SPI_HandleTypeDef;
+
+/**
+ * @brief Initializes the host SPI bus
+ * @param hspix: pointer to target SPI handle
+ * @param SPI_Mode: SPI_Mode_Master or SPI_Mode_Slave
+ * @param SPI_BaudRatePrescaler: SPI_BaudRatePrescaler_2...4,8,16,32,64,128,256
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t SPI_BaudRatePrescaler);
+
+/**
+ * @brief Changes the baud rate of initialized SPI
+ * @param hspix: pointer to target SPI handle
+ * @param SPI_BaudRatePrescaler: SPI_BaudRatePrescaler_2...4,8,16,32,64,128,256
+ * @param timeout: timeout duration of the wait for the end of communication
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_BaudRateConfig(SPI_HandleTypeDef *hspix, uint16_t SPI_BaudRatePrescaler, uint32_t timeout);
+
+/**
+ * @brief Gets the clock of the bus, SPI is connected to
+ * @param hspix: pointer to target SPI handle
+ * @return PCLK2 for SPI1, PCLK1 for SPI2 and SPI3 [Hz]
+ */
+uint32_t SPI_GetBusClock(const SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Gets SCK frequency
+ * @param hspix: pointer to target SPI handle
+ * @return SCK frequency [Hz]
+ */
+uint32_t SPI_GetClock(const SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Transmit an amount of data in blocking mode
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @param timeout: timeout duration
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_Transmit(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Receive an amount of data in blocking mode
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @param timeout: timeout duration
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
+
+/**
+ * @brief Transmit and receive an amount of data in blocking mode
+ * @param hspix: pointer to target SPI handle
+ * @param pDataTX: pointer to data source buffer, NULL - dummy bytes are transmitted
+ * @param pDataRX: pointer to data destination buffer, NULL - received data is discarded
+ * @param size: number of bytes to transfer
+ * @param timeout: timeout duration of the whole block
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_TransmitReceive(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                     uint32_t timeout);
+
+/**
+ * @brief Starts transmission of an amount of data in "DMA" mode
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @return SPI status right after the start
+ * @note The data is exchanged and SPI_TxRxCpltCallback() is called by SPI_IRQHandler()
+ */
+SPI_StateTypeDef SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Starts reception of an amount of data in "DMA" mode
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @return SPI status right after the start
+ * @note The data is exchanged and SPI_TxRxCpltCallback() is called by SPI_IRQHandler()
+ */
+SPI_StateTypeDef SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Same as SPI_Transmit_DMA()
+ */
+SPI_StateTypeDef SPI_Transmit_IT(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Same as SPI_Receive_DMA()
+ */
+SPI_StateTypeDef SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Drops the pending "DMA" or "IT" transfer, SPI_TxRxCpltCallback() is not called for it
+ * @param hspix: pointer to target SPI handle
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_Abort(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Completes the pending "DMA" or "IT" transfer, stands for the interrupt handler
+ * @param hspix: pointer to target SPI handle
+ * @note Advances the virtual time by the transfer duration, no-op without a pending transfer
+ */
+void SPI_IRQHandler(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Transfer completed callback
+ * @param hspix: pointer to target SPI handle
+ */
+void SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspix);
+
+#endif
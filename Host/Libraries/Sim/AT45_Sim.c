@@ -0,0 +1,629 @@
+#include "AT45_Sim.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define AT45_SIM_MAGIC "AT45SIM1"
+
+/* GPIO ports, which simulated devices are attached to */
+GPIO_TypeDef GPIOD_Instance;
+
+/* Self-timed operations */
+typedef enum AT45_SimOperation_e {
+    AT45_SIM_OP_NONE,
+    AT45_SIM_OP_TRANSFER, // tXFR: page to buffer transfer or compare
+    AT45_SIM_OP_PROGRAM, // tP
+    AT45_SIM_OP_ERASE_PROGRAM, // tEP
+    AT45_SIM_OP_PAGE_ERASE, // tPE
+    AT45_SIM_OP_BLOCK_ERASE, // tBE
+    AT45_SIM_OP_SECTOR_ERASE, // tSE
+    AT45_SIM_OP_CHIP_ERASE // tCE
+} AT45_SimOperation_t;
+
+/* AT45DB161E datasheet, the max values are the ones the driver waits for [us] */
+static const struct
+{
+    uint32_t typical;
+    uint32_t max;
+} AT45_SimDurations[] = {
+    [AT45_SIM_OP_NONE] = {0, 0},
+    [AT45_SIM_OP_TRANSFER] = {200, 200},
+    [AT45_SIM_OP_PROGRAM] = {2000, AT45_PAGE_PROGRAMMING_TIME * 1000},
+    [AT45_SIM_OP_ERASE_PROGRAM] = {15000, AT45_PAGE_ERASE_PROGRAMMING_TIME * 1000},
+    [AT45_SIM_OP_PAGE_ERASE] = {12000, AT45_PAGE_ERASE_TIME * 1000},
+    [AT45_SIM_OP_BLOCK_ERASE] = {45000, AT45_BLOCK_ERASE_TIME * 1000},
+    [AT45_SIM_OP_SECTOR_ERASE] = {1400000, AT45_SECTOR_ERASE_TIME * 1000},
+    [AT45_SIM_OP_CHIP_ERASE] = {22000000, AT45_CHIP_ERASE_TIME * 1000}};
+
+/* Address and dummy bytes, that follow the opcode */
+typedef struct
+{
+    uint8_t opcode;
+    uint8_t headerLength;
+    uint32_t maxClock; // Fastest SCK of the opcode [Hz], 0 - fSCK
+} AT45_SimOpcode_t;
+
+static const AT45_SimOpcode_t AT45_SimOpcodes[] = {
+    /* Read */
+    {AT45_CMD_MAIN_MEMORY_PAGE_READ, 3 + 4, 0},
+    {0xE8, 3 + 4, 0}, // Continuous Array Read (Legacy)
+    {AT45_CMD_CONTINUOUS_ARRAY_READ_HIGHEST_FREQUENCY, 3 + 2, 0},
+    {AT45_CMD_CONTINUOUS_ARRAY_READ_HIGH_FREQUENCY, 3 + 1, 0},
+    {AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_FREQUENCY, 3, AT45_LOW_FREQUENCY_READ_MAX_CLOCK},
+    {AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_POWER, 3, AT45_LOW_POWER_READ_MAX_CLOCK},
+    {AT45_CMD_BUFFER_1_READ, 3 + 1, 0},
+    {AT45_CMD_BUFFER_2_READ, 3 + 1, 0},
+    {AT45_CMD_BUFFER_1_READ_LOW_FREQUENCY, 3, AT45_LOW_FREQUENCY_READ_MAX_CLOCK},
+    {AT45_CMD_BUFFER_2_READ_LOW_FREQUENCY, 3, AT45_LOW_FREQUENCY_READ_MAX_CLOCK},
+    /* Program and erase */
+    {AT45_CMD_BUFFER_1_WRITE, 3, 0},
+    {AT45_CMD_BUFFER_2_WRITE, 3, 0},
+    {AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE, 3, 0},
+    {AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE, 3, 0},
+    {AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM, 3, 0},
+    {AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1_ERASE, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_2_ERASE, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1, 3, 0},
+    {AT45_CMD_PAGE_ERASE, 3, 0},
+    {AT45_CMD_BLOCK_ERASE, 3, 0},
+    {AT45_CMD_SECTOR_ERASE, 3, 0},
+    {AT45_CMD_CHIP_ERASE_0, 3, 0}, // + 0x94, 0x80, 0x9A
+    /* Additional */
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_TRANSFER, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_COMPARE, 3, 0},
+    {AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE, 3, 0},
+    {0x58, 3, 0}, // Auto Page Rewrite through Buffer 1
+    {0x59, 3, 0}, // Auto Page Rewrite through Buffer 2
+    {AT45_CMD_STATUS_REGISTER_READ, 0, 0},
+    {AT45_CMD_MANUFACTURER_DEVICE_ID_READ, 0, 0},
+    {AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_0, 3, 0} // + 0x2A, 0x80, 0xA6/0xA7
+};
+
+/* Private function prototypes */
+static void AT45_SimSelect(AT45_HandleTypeDef *AT45_Handle);
+static void AT45_SimDeselect(AT45_HandleTypeDef *AT45_Handle);
+static void AT45_SimTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout);
+static bool AT45_SimSubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size);
+static bool AT45_SimComplete(AT45_HandleTypeDef *AT45_Handle);
+static AT45_Sim_t *AT45_SimDevice(AT45_HandleTypeDef *AT45_Handle);
+static uint16_t AT45_SimPageSize(const AT45_Sim_t *sim);
+static void AT45_SimDecodeAddress(AT45_Sim_t *sim);
+static uint8_t AT45_SimStatus(const AT45_Sim_t *sim, uint32_t index);
+static bool AT45_SimBusy(const AT45_Sim_t *sim);
+static uint8_t AT45_SimBufferAccess(uint8_t opcode);
+static uint64_t AT45_SimDuration(AT45_Sim_t *sim, AT45_SimOperation_t operation);
+static AT45_SimOperation_t AT45_SimExecute(AT45_Sim_t *sim);
+static void AT45_SimErasePages(AT45_Sim_t *sim, uint32_t firstPage, uint32_t numberOfPages);
+static void AT45_SimProgram(AT45_Sim_t *sim, uint8_t bufferIndex, bool erase);
+static bool AT45_SimFault(AT45_Sim_t *sim);
+
+const AT45_Ops_t AT45_SimOps = {
+    .transfer = AT45_SimTransfer,
+    .select = AT45_SimSelect,
+    .deselect = AT45_SimDeselect,
+    .delay = AT45_Delay,
+    .tick = AT45_GetTick,
+    .submit = AT45_SimSubmit,
+    .complete = AT45_SimComplete,
+    .abort = NULL};
+
+ErrorStatus AT45_Sim_Init(AT45_Sim_t *sim, const char *backingFile)
+{
+    bool created = true;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->fd = -1;
+
+    if (backingFile == NULL)
+    {
+        sim->image = malloc(sizeof(*sim->image));
+        if (sim->image == NULL)
+            return ERROR;
+    }
+    else
+    {
+        sim->fd = open(backingFile, O_RDWR | O_CREAT, 0644);
+        if (sim->fd < 0)
+            return ERROR;
+        if (lseek(sim->fd, 0, SEEK_END) == (off_t) sizeof(*sim->image))
+            created = false;
+        else if (ftruncate(sim->fd, sizeof(*sim->image)) != 0)
+        {
+            close(sim->fd);
+            return ERROR;
+        }
+        sim->image = mmap(NULL, sizeof(*sim->image), PROT_READ | PROT_WRITE, MAP_SHARED, sim->fd, 0);
+        if (sim->image == MAP_FAILED)
+        {
+            close(sim->fd);
+            return ERROR;
+        }
+        if (!created && (memcmp(sim->image->magic, AT45_SIM_MAGIC, sizeof(sim->image->magic)) != 0))
+            created = true;
+    }
+
+    /* Factory state */
+    if (created)
+    {
+        memcpy(sim->image->magic, AT45_SIM_MAGIC, sizeof(sim->image->magic));
+        sim->image->binaryPageSize = 0;
+        memset(sim->image->memory, 0xFF, sizeof(sim->image->memory));
+    }
+
+    /* SRAM buffers content is undefined after power-up */
+    memset(sim->buffer, 0xFF, sizeof(sim->buffer));
+    sim->phase = AT45_SIM_IDLE;
+    sim->timing = AT45_SIM_TIMING_INSTANT;
+    sim->seed = 1;
+
+    return SUCCESS;
+}
+
+void AT45_Sim_DeInit(AT45_Sim_t *sim)
+{
+    if (sim->fd < 0)
+        free(sim->image);
+    else
+    {
+        msync(sim->image, sizeof(*sim->image), MS_SYNC);
+        munmap(sim->image, sizeof(*sim->image));
+        close(sim->fd);
+    }
+    sim->image = NULL;
+    sim->fd = -1;
+}
+
+void AT45_Sim_SetTiming(AT45_Sim_t *sim, AT45_SimTiming_t timing, uint32_t seed)
+{
+    sim->timing = timing;
+    sim->seed = (seed != 0) ? seed : 1;
+}
+
+void AT45_Sim_Attach(AT45_Sim_t *sim, GPIO_TypeDef *CS_Port, uint16_t CS_Pin)
+{
+    uint8_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        if (CS_Pin & (1u << i))
+            CS_Port->device[i] = sim;
+    }
+}
+
+void AT45_Sim_Select(AT45_Sim_t *sim)
+{
+    sim->phase = AT45_SIM_OPCODE;
+    sim->headerCount = 0;
+    sim->dataCount = 0;
+    sim->selectCount++;
+}
+
+void AT45_Sim_Deselect(AT45_Sim_t *sim)
+{
+    uint8_t busyBuffers = sim->busyBuffers;
+    AT45_SimOperation_t operation;
+
+    /* Self-timed operations start only if the command has been completely clocked in */
+    if ((sim->phase == AT45_SIM_DATA) && (sim->headerCount == sim->headerLength))
+    {
+        /* Buffer access while busy does not affect the operation in progress */
+        sim->busyBuffers = 0;
+        operation = AT45_SimExecute(sim);
+        if (operation != AT45_SIM_OP_NONE)
+            sim->busyUntil = Time_Get() + AT45_SimDuration(sim, operation);
+        else
+            sim->busyBuffers = busyBuffers;
+    }
+    sim->phase = AT45_SIM_IDLE;
+}
+
+uint8_t AT45_Sim_Exchange(void *device, uint8_t data)
+{
+    static const uint8_t ID[] = AT45_SIM_ID;
+    AT45_Sim_t *sim = device;
+    uint16_t pageSize = AT45_SimPageSize(sim);
+    uint8_t out = 0xFF;
+    size_t i;
+
+    sim->byteCount++;
+
+    switch (sim->phase)
+    {
+    case AT45_SIM_OPCODE:
+        sim->opcode = data;
+        sim->opcodeMaxClock = 0;
+        sim->phase = AT45_SIM_IDLE; // Unknown opcode: the rest of transaction is ignored
+        /* While busy, only the status and the buffers, not used by the operation, are accessible */
+        if ((data != AT45_CMD_STATUS_REGISTER_READ) && AT45_SimBusy(sim) &&
+            ((AT45_SimBufferAccess(data) == 0) || (AT45_SimBufferAccess(data) & sim->busyBuffers)))
+        {
+            sim->busyRejectCount++;
+            break;
+        }
+        for (i = 0; i < sizeof(AT45_SimOpcodes) / sizeof(AT45_SimOpcodes[0]); i++)
+        {
+            if (AT45_SimOpcodes[i].opcode == data)
+            {
+                sim->headerLength = AT45_SimOpcodes[i].headerLength;
+                sim->opcodeMaxClock = AT45_SimOpcodes[i].maxClock;
+                sim->phase = (sim->headerLength != 0) ? AT45_SIM_HEADER : AT45_SIM_DATA;
+                break;
+            }
+        }
+        if ((data == 0x02) && (sim->phase != AT45_SIM_IDLE))
+            memset(sim->bufferWritten, 0, sizeof(sim->bufferWritten));
+        break;
+
+    case AT45_SIM_HEADER:
+        sim->header[sim->headerCount++] = data;
+        if (sim->headerCount == sim->headerLength)
+        {
+            AT45_SimDecodeAddress(sim);
+            sim->phase = AT45_SIM_DATA;
+        }
+        break;
+
+    case AT45_SIM_DATA:
+        switch (sim->opcode)
+        {
+        /* Page read wraps within the page */
+        case AT45_CMD_MAIN_MEMORY_PAGE_READ:
+            out = sim->image->memory[sim->page][sim->offset];
+            sim->offset = (sim->offset + 1) % pageSize;
+            break;
+
+        /* Continuous reads go on to the next page and wrap at the end of the memory array */
+        case 0xE8:
+        case AT45_CMD_CONTINUOUS_ARRAY_READ_HIGHEST_FREQUENCY:
+        case AT45_CMD_CONTINUOUS_ARRAY_READ_HIGH_FREQUENCY:
+        case AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_FREQUENCY:
+        case AT45_CMD_CONTINUOUS_ARRAY_READ_LOW_POWER:
+            out = sim->image->memory[sim->page][sim->offset];
+            if (++sim->offset == pageSize)
+            {
+                sim->offset = 0;
+                sim->page = (sim->page + 1) % AT45_SIM_NUMBER_OF_PAGES;
+            }
+            break;
+
+        case AT45_CMD_BUFFER_1_READ:
+        case AT45_CMD_BUFFER_1_READ_LOW_FREQUENCY:
+            out = sim->buffer[0][sim->offset];
+            sim->offset = (sim->offset + 1) % pageSize;
+            break;
+
+        case AT45_CMD_BUFFER_2_READ:
+        case AT45_CMD_BUFFER_2_READ_LOW_FREQUENCY:
+            out = sim->buffer[1][sim->offset];
+            sim->offset = (sim->offset + 1) % pageSize;
+            break;
+
+        case AT45_CMD_BUFFER_1_WRITE:
+        case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1_ERASE:
+        case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1:
+            sim->buffer[0][sim->offset] = data;
+            sim->bufferWritten[sim->offset] = true;
+            sim->offset = (sim->offset + 1) % pageSize;
+            break;
+
+        case AT45_CMD_BUFFER_2_WRITE:
+        case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_2_ERASE:
+            sim->buffer[1][sim->offset] = data;
+            sim->offset = (sim->offset + 1) % pageSize;
+            break;
+
+        case AT45_CMD_STATUS_REGISTER_READ:
+            out = AT45_SimStatus(sim, sim->dataCount);
+            if ((sim->dataCount % 2) == 1)
+                sim->statusPollCount++;
+            break;
+
+        case AT45_CMD_MANUFACTURER_DEVICE_ID_READ:
+            out = (sim->dataCount < sizeof(ID)) ? ID[sim->dataCount] : 0x00;
+            break;
+
+        default:
+            /* Any byte after the header cancels the self-timed operations */
+            sim->phase = AT45_SIM_IDLE;
+            break;
+        }
+        sim->dataCount++;
+        break;
+
+    default:
+        break;
+    }
+
+    /* Too fast clock for the device or for the opcode: SO is sampled one bit late */
+    if (((sim->maxClock != 0) && (sim->clock > sim->maxClock)) ||
+        ((sim->opcodeMaxClock != 0) && (sim->clock > sim->opcodeMaxClock)))
+        out = (uint8_t) ((out >> 1) | 0x80);
+
+    return out;
+}
+
+/**
+ * @section Private functions
+ */
+static void AT45_SimSelect(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Sim_t *sim = AT45_SimDevice(AT45_Handle);
+
+    AT45_SPI_SetPrescaler(AT45_Handle->hspix, AT45_Handle->baudRatePrescaler);
+    AT45_Handle->hspix->device = sim;
+    AT45_Handle->hspix->exchange = (sim != NULL) ? AT45_Sim_Exchange : NULL;
+    if (sim != NULL)
+    {
+        sim->clock = SPI_GetClock(AT45_Handle->hspix);
+        AT45_Sim_Select(sim);
+    }
+}
+
+static void AT45_SimDeselect(AT45_HandleTypeDef *AT45_Handle)
+{
+    AT45_Sim_t *sim = AT45_SimDevice(AT45_Handle);
+
+    AT45_Handle->hspix->device = NULL;
+    AT45_Handle->hspix->exchange = NULL;
+    if (sim != NULL)
+        AT45_Sim_Deselect(sim);
+}
+
+static void AT45_SimTransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout)
+{
+    if (pRX == NULL)
+        AT45_SPI_Transmit(AT45_Handle->hspix, (uint8_t *) pTX, size, timeout);
+    else
+        AT45_SPI_Receive(AT45_Handle->hspix, pRX, size, timeout);
+}
+
+/* Non-blocking transfer is modelled as the one, that is already complete */
+static bool AT45_SimSubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size)
+{
+    AT45_SimTransfer(AT45_Handle, pTX, pRX, size, AT45_RX_TIMEOUT);
+
+    return true;
+}
+
+static bool AT45_SimComplete(AT45_HandleTypeDef *AT45_Handle)
+{
+    (void) AT45_Handle;
+
+    return true;
+}
+
+static AT45_Sim_t *AT45_SimDevice(AT45_HandleTypeDef *AT45_Handle)
+{
+    uint8_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        if (AT45_Handle->CS_Pin & (1u << i))
+            return AT45_Handle->CS_Port->device[i];
+    }
+
+    return NULL;
+}
+
+static uint16_t AT45_SimPageSize(const AT45_Sim_t *sim)
+{
+    return sim->image->binaryPageSize ? AT45_SIM_PAGE_SIZE_BINARY : AT45_SIM_PAGE_SIZE_STANDARD;
+}
+
+static void AT45_SimDecodeAddress(AT45_Sim_t *sim)
+{
+    uint32_t address;
+    uint8_t byteBits = sim->image->binaryPageSize ? 9 : 10;
+
+    if (sim->headerLength < 3)
+        return;
+
+    address = ((uint32_t) sim->header[0] << 16) | ((uint32_t) sim->header[1] << 8) | sim->header[2];
+    sim->page = (address >> byteBits) % AT45_SIM_NUMBER_OF_PAGES;
+    sim->offset = (address & ((1u << byteBits) - 1)) % AT45_SimPageSize(sim);
+}
+
+static uint8_t AT45_SimStatus(const AT45_Sim_t *sim, uint32_t index)
+{
+    uint8_t ready = AT45_SimBusy(sim) ? 0x00 : 0x80;
+
+    /* Both bytes are output repeatedly, RDY is sampled for every byte */
+    if ((index % 2) == 0)
+        return ready | (sim->compareMismatch ? 0x40 : 0x00) | AT45_SIM_DENSITY_CODE |
+               (sim->image->binaryPageSize ? 0x01 : 0x00);
+
+    return ready | (sim->eraseProgramError ? 0x20 : 0x00);
+}
+
+static bool AT45_SimBusy(const AT45_Sim_t *sim)
+{
+    return Time_Get() < sim->busyUntil;
+}
+
+/* Buffer, read or written by the command: bit 0 - buffer 1, bit 1 - buffer 2, 0 - no buffer access */
+static uint8_t AT45_SimBufferAccess(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case AT45_CMD_BUFFER_1_READ:
+    case AT45_CMD_BUFFER_1_READ_LOW_FREQUENCY:
+    case AT45_CMD_BUFFER_1_WRITE:
+        return 1u << 0;
+
+    case AT45_CMD_BUFFER_2_READ:
+    case AT45_CMD_BUFFER_2_READ_LOW_FREQUENCY:
+    case AT45_CMD_BUFFER_2_WRITE:
+        return 1u << 1;
+
+    default:
+        return 0;
+    }
+}
+
+static uint64_t AT45_SimDuration(AT45_Sim_t *sim, AT45_SimOperation_t operation)
+{
+    uint32_t typical = AT45_SimDurations[operation].typical;
+    uint32_t max = AT45_SimDurations[operation].max;
+
+    switch (sim->timing)
+    {
+    case AT45_SIM_TIMING_TYPICAL:
+        return typical * TIME_PS_PER_US;
+
+    case AT45_SIM_TIMING_MAX:
+        return max * TIME_PS_PER_US;
+
+    case AT45_SIM_TIMING_RANDOM:
+        /* xorshift32 */
+        sim->seed ^= sim->seed << 13;
+        sim->seed ^= sim->seed >> 17;
+        sim->seed ^= sim->seed << 5;
+        return (typical + (uint64_t) sim->seed % (max - typical + 1)) * TIME_PS_PER_US;
+
+    default:
+        return 0;
+    }
+}
+
+static AT45_SimOperation_t AT45_SimExecute(AT45_Sim_t *sim)
+{
+    uint16_t pageSize = AT45_SimPageSize(sim);
+    uint32_t sector;
+
+    switch (sim->opcode)
+    {
+    case AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE:
+    case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1_ERASE:
+        AT45_SimProgram(sim, 0, true);
+        sim->busyBuffers = 1u << 0;
+        return AT45_SIM_OP_ERASE_PROGRAM;
+
+    case AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM_ERASE:
+    case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_2_ERASE:
+        AT45_SimProgram(sim, 1, true);
+        sim->busyBuffers = 1u << 1;
+        return AT45_SIM_OP_ERASE_PROGRAM;
+
+    case AT45_CMD_BUFFER_1_TO_MAIN_MEMORY_PAGE_PROGRAM:
+        AT45_SimProgram(sim, 0, false);
+        sim->busyBuffers = 1u << 0;
+        return AT45_SIM_OP_PROGRAM;
+
+    case AT45_CMD_BUFFER_2_TO_MAIN_MEMORY_PAGE_PROGRAM:
+        AT45_SimProgram(sim, 1, false);
+        sim->busyBuffers = 1u << 1;
+        return AT45_SIM_OP_PROGRAM;
+
+    /* Only the bytes clocked in are programmed */
+    case AT45_CMD_MAIN_MEMORY_PAGE_PROGRAM_THROUGH_BUFFER_1:
+        sim->busyBuffers = 1u << 0;
+        for (uint16_t i = 0; i < pageSize; i++)
+        {
+            if (sim->bufferWritten[i])
+                sim->image->memory[sim->page][i] &= sim->buffer[0][i];
+        }
+        sim->eraseProgramError = AT45_SimFault(sim);
+        return AT45_SIM_OP_PROGRAM;
+
+    case AT45_CMD_PAGE_ERASE:
+        AT45_SimErasePages(sim, sim->page, 1);
+        return AT45_SIM_OP_PAGE_ERASE;
+
+    case AT45_CMD_BLOCK_ERASE:
+        AT45_SimErasePages(sim, sim->page - (sim->page % AT45_SIM_PAGES_PER_BLOCK), AT45_SIM_PAGES_PER_BLOCK);
+        return AT45_SIM_OP_BLOCK_ERASE;
+
+    /* Sector 0 is split into 0a (block 0) and 0b (the rest) */
+    case AT45_CMD_SECTOR_ERASE:
+        sector = sim->page / AT45_SIM_PAGES_PER_SECTOR;
+        if (sector != 0)
+            AT45_SimErasePages(sim, sector * AT45_SIM_PAGES_PER_SECTOR, AT45_SIM_PAGES_PER_SECTOR);
+        else if (sim->page < AT45_SIM_SECTOR_0A_PAGES)
+            AT45_SimErasePages(sim, 0, AT45_SIM_SECTOR_0A_PAGES);
+        else
+            AT45_SimErasePages(sim, AT45_SIM_SECTOR_0A_PAGES, AT45_SIM_PAGES_PER_SECTOR - AT45_SIM_SECTOR_0A_PAGES);
+        return AT45_SIM_OP_SECTOR_ERASE;
+
+    case AT45_CMD_CHIP_ERASE_0:
+        if ((sim->header[0] != AT45_CMD_CHIP_ERASE_1) || (sim->header[1] != AT45_CMD_CHIP_ERASE_2) ||
+            (sim->header[2] != AT45_CMD_CHIP_ERASE_3))
+            return AT45_SIM_OP_NONE;
+        AT45_SimErasePages(sim, 0, AT45_SIM_NUMBER_OF_PAGES);
+        return AT45_SIM_OP_CHIP_ERASE;
+
+    /* Nonvolatile configuration register is programmed as a page */
+    case AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_0:
+        if ((sim->header[0] != AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_1) ||
+            (sim->header[1] != AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_2))
+            return AT45_SIM_OP_NONE;
+        if (sim->header[2] == AT45_CMD_CONFIGURE_BINARY_PAGE_SIZE_3)
+            sim->image->binaryPageSize = 1;
+        else if (sim->header[2] == AT45_CMD_CONFIGURE_STANDART_PAGE_SIZE_3)
+            sim->image->binaryPageSize = 0;
+        else
+            return AT45_SIM_OP_NONE;
+        return AT45_SIM_OP_ERASE_PROGRAM;
+
+    case AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_TRANSFER:
+    case AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER:
+        memcpy(sim->buffer[sim->opcode == AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER], sim->image->memory[sim->page],
+               pageSize);
+        sim->busyBuffers = 1u << (sim->opcode == AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_TRANSFER);
+        return AT45_SIM_OP_TRANSFER;
+
+    case AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_1_COMPARE:
+    case AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE:
+        sim->busyBuffers = 1u << (sim->opcode == AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE);
+        sim->compareMismatch = memcmp(sim->buffer[sim->opcode == AT45_CMD_MAIN_MEMORY_PAGE_TO_BUFFER_2_COMPARE],
+                                      sim->image->memory[sim->page], pageSize) != 0;
+        return AT45_SIM_OP_TRANSFER;
+
+    case 0x58:
+    case 0x59:
+        sim->busyBuffers = 1u << (sim->opcode == 0x59);
+        memcpy(sim->buffer[sim->opcode == 0x59], sim->image->memory[sim->page], pageSize);
+        AT45_SimProgram(sim, sim->opcode == 0x59, true);
+        return AT45_SIM_OP_ERASE_PROGRAM;
+
+    default:
+        return AT45_SIM_OP_NONE;
+    }
+}
+
+static void AT45_SimErasePages(AT45_Sim_t *sim, uint32_t firstPage, uint32_t numberOfPages)
+{
+    memset(sim->image->memory[firstPage], 0xFF, numberOfPages * AT45_SIM_PAGE_SIZE_STANDARD);
+    sim->eraseProgramError = AT45_SimFault(sim);
+}
+
+static void AT45_SimProgram(AT45_Sim_t *sim, uint8_t bufferIndex, bool erase)
+{
+    uint16_t pageSize = AT45_SimPageSize(sim);
+    uint16_t i;
+
+    if (erase)
+        memset(sim->image->memory[sim->page], 0xFF, pageSize);
+
+    /* Programming can only clear bits */
+    for (i = 0; i < pageSize; i++)
+        sim->image->memory[sim->page][i] &= sim->buffer[bufferIndex][i];
+    sim->eraseProgramError = AT45_SimFault(sim);
+}
+
+static bool AT45_SimFault(AT45_Sim_t *sim)
+{
+    if (!sim->programFault)
+        return false;
+    if (sim->programFaultSkip != 0)
+    {
+        sim->programFaultSkip--;
+        return false;
+    }
+    sim->programFault = false;
+
+    return true;
+}
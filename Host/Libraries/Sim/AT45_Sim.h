@@ -0,0 +1,132 @@
+#ifndef AT45_SIM_H
+#define AT45_SIM_H
+
+#include "AT45.h"
+
+/* AT45DB161E geometry */
+#define AT45_SIM_NUMBER_OF_PAGES   4096
+#define AT45_SIM_PAGE_SIZE_STANDARD 528
+#define AT45_SIM_PAGE_SIZE_BINARY   512
+#define AT45_SIM_PAGES_PER_BLOCK   8
+#define AT45_SIM_PAGES_PER_SECTOR  256
+#define AT45_SIM_SECTOR_0A_PAGES   8
+
+/* Identification */
+#define AT45_SIM_ID { 0x1F, 0x26, 0x00, 0x01, 0x00 }
+#define AT45_SIM_DENSITY_CODE 0x2C // Status register byte 1, bits 5-2
+
+/* Duration of self-timed operations */
+typedef enum AT45_SimTiming_e {
+    AT45_SIM_TIMING_INSTANT, // Operations complete on CS rising edge
+    AT45_SIM_TIMING_TYPICAL,
+    AT45_SIM_TIMING_MAX,
+    AT45_SIM_TIMING_RANDOM // Uniformly distributed between typical and max
+} AT45_SimTiming_t;
+
+typedef enum AT45_SimPhase_e { AT45_SIM_IDLE, AT45_SIM_OPCODE, AT45_SIM_HEADER, AT45_SIM_DATA } AT45_SimPhase_t;
+
+/* Persistent part of the device, mapped from the backing file if any */
+typedef struct AT45_SimImage_s
+{
+    char magic[8];
+    uint32_t binaryPageSize;
+    uint32_t reserved[13];
+    uint8_t memory[AT45_SIM_NUMBER_OF_PAGES][AT45_SIM_PAGE_SIZE_STANDARD];
+} AT45_SimImage_t;
+
+typedef struct AT45_Sim_s
+{
+    AT45_SimImage_t *image;
+    int fd; // Backing file descriptor, -1 - anonymous memory
+    uint8_t buffer[2][AT45_SIM_PAGE_SIZE_STANDARD];
+    bool bufferWritten[AT45_SIM_PAGE_SIZE_STANDARD]; // Bytes of Buffer 1 clocked in by opcode 0x02
+    bool compareMismatch;
+    bool eraseProgramError;
+    bool programFault; // Fault injection: the next program or erase reports EPE
+    uint32_t programFaultSkip; // Programs and erases to pass before the faulty one
+
+    /* Signal integrity */
+    uint32_t maxClock; // Fastest SCK, at which SO is still sampled correctly [Hz], 0 - no limit
+    uint32_t clock; // SCK of the current transaction [Hz]
+
+    /* Virtual time */
+    AT45_SimTiming_t timing;
+    uint32_t seed;
+    uint64_t busyUntil; // End of the self-timed operation [ps]
+    uint8_t busyBuffers; // Buffers, used by the self-timed operation: bit 0 - buffer 1, bit 1 - buffer 2
+
+    /* Command in progress */
+    AT45_SimPhase_t phase;
+    uint8_t opcode;
+    uint8_t header[8];
+    uint8_t headerCount;
+    uint8_t headerLength;
+    uint32_t opcodeMaxClock; // Fastest SCK of the command in progress [Hz], 0 - fSCK
+    uint16_t page;
+    uint16_t offset;
+    uint32_t dataCount;
+
+    /* Bus statistics */
+    uint32_t selectCount;
+    uint64_t byteCount;
+    uint32_t statusPollCount; // Complete status register outputs
+    uint32_t busyRejectCount; // Commands ignored while the device was busy
+} AT45_Sim_t;
+
+/* Transport, that routes the device handle to the simulator attached to its CS pin */
+extern const AT45_Ops_t AT45_SimOps;
+
+/**
+ * @brief Powers the simulated device up
+ * @param sim: pointer to the simulator instance
+ * @param backingFile: path of the memory-mapped image, NULL - volatile memory
+ * @return SUCCESS or ERROR if the image couldn't be created or mapped
+ * @note A new image is erased (0xFF) and configured for the standard 528-byte page size
+ */
+ErrorStatus AT45_Sim_Init(AT45_Sim_t *sim, const char *backingFile);
+
+/**
+ * @brief Powers the simulated device down, the backing file keeps the memory contents
+ * @param sim: pointer to the simulator instance
+ */
+void AT45_Sim_DeInit(AT45_Sim_t *sim);
+
+/**
+ * @brief Selects the duration model of program and erase operations
+ * @param sim: pointer to the simulator instance
+ * @param timing: duration model
+ * @param seed: initial state of AT45_SIM_TIMING_RANDOM generator, must be non-zero
+ * @note Self-timed operations run on the virtual clock (Time_Get()), which is also advanced by SPI
+ * transfers and Delay(). Only status register read is accepted while the device is busy.
+ */
+void AT45_Sim_SetTiming(AT45_Sim_t *sim, AT45_SimTiming_t timing, uint32_t seed);
+
+/**
+ * @brief Connects the simulated device to CS pin
+ * @param sim: pointer to the simulator instance
+ * @param CS_Port: GPIOx
+ * @param CS_Pin: GPIO_Pin_x
+ */
+void AT45_Sim_Attach(AT45_Sim_t *sim, GPIO_TypeDef *CS_Port, uint16_t CS_Pin);
+
+/**
+ * @brief CS falling edge
+ * @param sim: pointer to the simulator instance
+ */
+void AT45_Sim_Select(AT45_Sim_t *sim);
+
+/**
+ * @brief CS rising edge, starts self-timed operations
+ * @param sim: pointer to the simulator instance
+ */
+void AT45_Sim_Deselect(AT45_Sim_t *sim);
+
+/**
+ * @brief Exchanges one byte over the bus
+ * @param device: pointer to the simulator instance
+ * @param data: byte on SI
+ * @return Byte on SO
+ */
+uint8_t AT45_Sim_Exchange(void *device, uint8_t data);
+
+#endif
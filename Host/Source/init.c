@@ -0,0 +1,20 @@
+#include "init.h"
+
+/* Public variables */
+SPI_HandleTypeDef hspi3;
+AT45_Sim_t AT45_Sim0;
+
+void IO_Init(const char *backingFile)
+{
+    /* SPI3 */
+    hspi3.Instance = SPI3;
+
+    /* PD0 - NSS */
+    SET_BIT(CS0_GPIO_Port->BSRR, CS0_Pin);
+    if (AT45_Sim_Init(&AT45_Sim0, backingFile) != SUCCESS)
+    {
+        perror(backingFile);
+        Error_Handler();
+    }
+    AT45_Sim_Attach(&AT45_Sim0, CS0_GPIO_Port, CS0_Pin);
+}
@@ -0,0 +1,60 @@
+#include "main.h"
+
+/* Private variables */
+static AT45_HandleTypeDef AT45_Handle;
+static const uint8_t bufferWrite[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 'A', 'B', 'C'};
+static uint8_t bufferRead[sizeof(bufferWrite)] = {0};
+
+int main(int argc, char *argv[])
+{
+    IO_Init((argc > 1) ? argv[1] : NULL);
+    SPIx_Init(&hspi3, SPI_Mode_Master, SPI_BaudRatePrescaler_256);
+    AT45_Handle.ops = &AT45_SimOps;
+    AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin);
+    if (AT45_Handle.status == AT45_STATUS_READY)
+    {
+        printf("\r\n First approach to read \r\n");
+        AT45_Read(&AT45_Handle, bufferRead, sizeof(bufferRead), PAGE_ADDRESS, true);
+        if (strncmp((const char *) bufferRead, (const char *) bufferWrite, sizeof(bufferRead)) == 0)
+        {
+            printf("Data already exist at page %i boundaries \r\n", PAGE);
+        }
+        else
+        {
+            printf("Data doesn't exist at page %i boundaries \r\n", PAGE);
+            printf("Page programming...");
+            AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), PAGE_ADDRESS, true, true, AT45_WAIT_VERIFY);
+            printf("\r\n On-chip verify \r\n");
+            if (AT45_Handle.status == AT45_STATUS_READY)
+            {
+                printf("Writing process success \r\n");
+            }
+            else
+            {
+                printf("Writing process failure \r\n");
+                Error_Handler();
+            }
+        }
+    }
+    else
+    {
+        printf("Couldn't get any response from device \r\n");
+        Error_Handler();
+    }
+
+    printf("SPI transactions: %u, bytes: %llu \r\n", (unsigned) AT45_Sim0.selectCount,
+           (unsigned long long) AT45_Sim0.byteCount);
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    return 0;
+}
+
+/**
+ * @brief  This function is executed in case of error occurrence.
+ * @retval None
+ */
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler() has been called \r\n");
+    abort();
+}
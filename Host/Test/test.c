@@ -0,0 +1,531 @@
+/* Regression tests of the driver against the simulator, the exit code is the number of failed checks */
+#include "init.h"
+#include "AT45.h"
+#include <stdio.h>
+
+#define TEST_SEED 0x2545F491
+
+#define TEST_CHECK(CONDITION)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        checks++;                                                                                                      \
+        if (!(CONDITION))                                                                                              \
+        {                                                                                                              \
+            failures++;                                                                                                \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #CONDITION);                                              \
+        }                                                                                                              \
+    } while (0)
+
+typedef struct
+{
+    const char *name;
+    void (*run)(void);
+} TestCase_t;
+
+static AT45_HandleTypeDef AT45_Handle;
+static uint8_t pattern[AT45_BLOCK_SIZE * 4];
+static uint8_t buffer[AT45_BLOCK_SIZE * 4];
+static uint32_t checks;
+static uint32_t failures;
+
+/* Completions, delivered to AT45_WriteCpltCallback */
+static uint32_t completedTokens[8];
+static AT45_Status_t completedResults[8];
+static uint32_t completedCount;
+
+/* DMA transport on the simulated bus: the simulator selects the device, SPI_IRQHandler() stands for the interrupt */
+static void Test_DMATransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout);
+static bool Test_DMASubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size);
+static bool Test_DMAComplete(AT45_HandleTypeDef *AT45_Handle);
+
+static AT45_Ops_t Test_DMAOps;
+static uint32_t idleCount;
+static uint32_t pendingCount;
+static bool dmaStall; // The transfer never completes, only the time runs
+
+void AT45_WriteCpltCallback(AT45_HandleTypeDef *AT45_Handle, uint32_t token, AT45_Status_t result)
+{
+    (void) AT45_Handle;
+
+    if (completedCount < (sizeof(completedTokens) / sizeof(completedTokens[0])))
+    {
+        completedTokens[completedCount] = token;
+        completedResults[completedCount] = result;
+    }
+    completedCount++;
+}
+
+void AT45_SPI_Idle(void)
+{
+    idleCount++;
+    SPI_IRQHandler(&hspi3);
+}
+
+static void Test_DMATransfer(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size,
+                             uint32_t timeout)
+{
+    AT45_DMAOps.transfer(AT45_Handle, pTX, pRX, size, timeout);
+}
+
+static bool Test_DMASubmit(AT45_HandleTypeDef *AT45_Handle, const uint8_t *pTX, uint8_t *pRX, uint16_t size)
+{
+    return AT45_DMAOps.submit(AT45_Handle, pTX, pRX, size);
+}
+
+static bool Test_DMAComplete(AT45_HandleTypeDef *AT45_Handle)
+{
+    if (AT45_DMAOps.complete(AT45_Handle))
+        return true;
+
+    pendingCount++;
+    if (dmaStall)
+    {
+        Delay(1);
+        return false;
+    }
+    SPI_IRQHandler(AT45_Handle->hspix);
+
+    return AT45_DMAOps.complete(AT45_Handle);
+}
+
+/* Fresh erased device with the polling transport for every case */
+static void Test_Setup(AT45_SimTiming_t timing)
+{
+    if (AT45_Sim_Init(&AT45_Sim0, NULL) != SUCCESS)
+        Error_Handler();
+    SPIx_Init(&hspi3, SPI_Mode_Master, SPI_BaudRatePrescaler_4);
+    memset(&AT45_Handle, 0, sizeof(AT45_Handle));
+    AT45_Handle.ops = &AT45_SimOps;
+    if (AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin) != AT45_STATUS_READY)
+        Error_Handler();
+    AT45_Sim_SetTiming(&AT45_Sim0, timing, TEST_SEED);
+    completedCount = 0;
+}
+
+static void Test_Teardown(void)
+{
+    AT45_Sim_DeInit(&AT45_Sim0);
+}
+
+static void Test_ReadWrite(void)
+{
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    /* Frame with CRC at a byte address, the rest of the page is kept */
+    memset(buffer, 0x5A, AT45_PAGE_SIZE);
+    TEST_CHECK(AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE, 7 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK(AT45_Write(&AT45_Handle, pattern, 100, 7 * AT45_PAGE_SIZE + 200, true, true, AT45_WAIT_VERIFY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK(AT45_Sim0.image->memory[7][199] == 0x5A);
+    TEST_CHECK(AT45_Sim0.image->memory[7][302] == 0x5A);
+    TEST_CHECK(memcmp(&AT45_Sim0.image->memory[7][200], pattern, 100) == 0);
+
+    /* From the SRAM buffer, then from main memory */
+    memset(buffer, 0, sizeof(buffer));
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 100, 7 * AT45_PAGE_SIZE + 200, true) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, pattern, 100) == 0);
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+    memset(buffer, 0, sizeof(buffer));
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 100, 7 * AT45_PAGE_SIZE + 200, true) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, pattern, 100) == 0);
+
+    /* Corrupted frame */
+    AT45_Sim0.image->memory[7][250] ^= 0x01;
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 100, 7 * AT45_PAGE_SIZE + 200, true) == AT45_STATUS_ERROR_CHECKSUM);
+
+    /* Argument guards */
+    TEST_CHECK(AT45_Write(&AT45_Handle, pattern, 511, 8 * AT45_PAGE_SIZE, true, true, AT45_WAIT_BUSY) ==
+               AT45_STATUS_ERROR_ARGUMENT);
+    TEST_CHECK(AT45_Write(&AT45_Handle, pattern, 1, AT45_PAGE_SIZE * AT45_Handle.numberOfPages, false, true,
+                          AT45_WAIT_BUSY) == AT45_STATUS_ERROR_ARGUMENT);
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 2, 9 * AT45_PAGE_SIZE - 1, false) == AT45_STATUS_ERROR_ARGUMENT);
+
+    Test_Teardown();
+}
+
+static void Test_Streams(void)
+{
+    uint32_t address = 20 * AT45_PAGE_SIZE + 100;
+    uint32_t length = 3 * AT45_PAGE_SIZE + 50;
+
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    memset(buffer, 0x5A, AT45_PAGE_SIZE);
+    AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE, 20 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE, 23 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+
+    /* Leading and trailing partial pages keep the rest of their contents */
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, length, address, false, true, AT45_WAIT_VERIFY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK(AT45_Sim0.image->memory[20][99] == 0x5A);
+    TEST_CHECK(AT45_Sim0.image->memory[23][150] == 0x5A);
+    memset(buffer, 0, sizeof(buffer));
+    TEST_CHECK(AT45_ReadStream(&AT45_Handle, buffer, length, address) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, pattern, length) == 0);
+
+    /* One CRC frame per page */
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, 1000, 40 * AT45_PAGE_SIZE, true, true, AT45_WAIT_BUSY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE - 2, 40 * AT45_PAGE_SIZE, true) == AT45_STATUS_READY);
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 1000 - (AT45_PAGE_SIZE - 2), 41 * AT45_PAGE_SIZE, true) ==
+               AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, &pattern[AT45_PAGE_SIZE - 2], 1000 - (AT45_PAGE_SIZE - 2)) == 0);
+
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, 1000, (AT45_Handle.numberOfPages - 1) * AT45_PAGE_SIZE,
+                                false, true, AT45_WAIT_BUSY) == AT45_STATUS_ERROR_ARGUMENT);
+
+    Test_Teardown();
+}
+
+static void Test_ReadVector(void)
+{
+    uint8_t first[32], second[16], third[64];
+    AT45_ReadRequest_t requests[] = {{2 * AT45_PAGE_SIZE + 300, sizeof(first), first},
+                                     {2 * AT45_PAGE_SIZE + 10, sizeof(second), second},
+                                     {2 * AT45_PAGE_SIZE + 40, sizeof(third), third}};
+    uint32_t selectCount;
+
+    Test_Setup(AT45_SIM_TIMING_INSTANT);
+
+    AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 2 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+
+    /* The two close fragments are coalesced, the far one gets its own command */
+    selectCount = AT45_Sim0.selectCount;
+    TEST_CHECK(AT45_ReadVector(&AT45_Handle, requests, 3, AT45_READ_VECTOR_GAP * 2) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(first, &pattern[300], sizeof(first)) == 0);
+    TEST_CHECK(memcmp(second, &pattern[10], sizeof(second)) == 0);
+    TEST_CHECK(memcmp(third, &pattern[40], sizeof(third)) == 0);
+    TEST_CHECK((AT45_Sim0.selectCount - selectCount) <= 4); // Status poll and two reads
+
+    Test_Teardown();
+}
+
+static void Test_Update(void)
+{
+    uint8_t patch[16];
+    uint64_t byteCount;
+
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    memset(patch, 0xA5, sizeof(patch));
+    AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 10 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 11 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 12 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+
+    /* Page transfer to the buffer, then the held page is updated without it */
+    TEST_CHECK(AT45_Update(&AT45_Handle, 10 * AT45_PAGE_SIZE, 200, patch, sizeof(patch), AT45_WAIT_VERIFY) ==
+               AT45_STATUS_READY);
+    byteCount = AT45_Sim0.byteCount;
+    TEST_CHECK(AT45_Update(&AT45_Handle, 10 * AT45_PAGE_SIZE, 300, patch, sizeof(patch), AT45_WAIT_NO) ==
+               AT45_STATUS_READY);
+    TEST_CHECK((AT45_Sim0.byteCount - byteCount) < 64);
+    TEST_CHECK(AT45_Verify(&AT45_Handle, 10 * AT45_PAGE_SIZE) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(&AT45_Sim0.image->memory[10][200], patch, sizeof(patch)) == 0);
+    TEST_CHECK(memcmp(&AT45_Sim0.image->memory[10][300], patch, sizeof(patch)) == 0);
+    TEST_CHECK(memcmp(AT45_Sim0.image->memory[10], pattern, 200) == 0);
+    TEST_CHECK(memcmp(&AT45_Sim0.image->memory[10][316], &pattern[316], AT45_PAGE_SIZE - 316) == 0);
+
+    TEST_CHECK(AT45_Update(&AT45_Handle, 10 * AT45_PAGE_SIZE + 1, 0, patch, 1, AT45_WAIT_BUSY) ==
+               AT45_STATUS_ERROR_ARGUMENT);
+    TEST_CHECK(AT45_Update(&AT45_Handle, 10 * AT45_PAGE_SIZE, 510, patch, 3, AT45_WAIT_BUSY) ==
+               AT45_STATUS_ERROR_ARGUMENT);
+
+    Test_Teardown();
+}
+
+static void Test_PingPong(void)
+{
+    uint32_t page;
+    bool match = true;
+
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    /* The next buffer is filled while the previous page is programmed, nothing is rejected by the busy device */
+    for (page = 100; page < 116; page++)
+        TEST_CHECK(AT45_Write(&AT45_Handle, &pattern[(page % 4) * AT45_PAGE_SIZE], AT45_PAGE_SIZE,
+                              page * AT45_PAGE_SIZE, false, true, AT45_WAIT_NO) == AT45_STATUS_READY);
+    TEST_CHECK(AT45_Busy(&AT45_Handle));
+    TEST_CHECK(AT45_Verify(&AT45_Handle, 115 * AT45_PAGE_SIZE) == AT45_STATUS_READY);
+    for (page = 100; page < 116; page++)
+        match &= memcmp(AT45_Sim0.image->memory[page], &pattern[(page % 4) * AT45_PAGE_SIZE], AT45_PAGE_SIZE) == 0;
+    TEST_CHECK(match);
+    TEST_CHECK(AT45_Sim0.busyRejectCount == 0);
+
+    Test_Teardown();
+}
+
+static void Test_Cache(void)
+{
+    static AT45_CacheSlot_t slots[2];
+    uint32_t i;
+
+    Test_Setup(AT45_SIM_TIMING_INSTANT);
+
+    AT45_WriteStream(&AT45_Handle, pattern, 3 * AT45_PAGE_SIZE, 50 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Erase(&AT45_Handle, AT45_PAGE_ERASE, 0, AT45_WAIT_BUSY); // Buffers no longer hold the pages
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+    TEST_CHECK(AT45_CacheConfig(&AT45_Handle, slots, 2) == AT45_STATUS_READY);
+
+    for (i = 0; i < 10; i++)
+    {
+        TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 16, (50 + (i % 2)) * AT45_PAGE_SIZE + 8, false) ==
+                   AT45_STATUS_READY);
+        TEST_CHECK(memcmp(buffer, &pattern[(i % 2) * AT45_PAGE_SIZE + 8], 16) == 0);
+    }
+    TEST_CHECK(AT45_Handle.cache.misses == 2);
+    TEST_CHECK(AT45_Handle.cache.hits == 8);
+
+    /* Least recently used page is evicted, the written page is dropped */
+    AT45_Read(&AT45_Handle, buffer, 16, 52 * AT45_PAGE_SIZE, false);
+    TEST_CHECK(AT45_Handle.cache.evictions == 1);
+    AT45_Write(&AT45_Handle, pattern, 16, 52 * AT45_PAGE_SIZE + 100, false, true, AT45_WAIT_BUSY);
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 16, 52 * AT45_PAGE_SIZE + 100, false) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, pattern, 16) == 0);
+
+    Test_Teardown();
+}
+
+static void Test_Prefetch(void)
+{
+    static uint8_t memory[2 * AT45_PAGE_SIZE];
+    uint32_t page;
+    bool match = true;
+
+    Test_Setup(AT45_SIM_TIMING_INSTANT);
+
+    AT45_WriteStream(&AT45_Handle, pattern, sizeof(pattern), 60 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    AT45_Erase(&AT45_Handle, AT45_PAGE_ERASE, 0, AT45_WAIT_BUSY);
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+    TEST_CHECK(AT45_PrefetchConfig(&AT45_Handle, memory, 2) == AT45_STATUS_READY);
+
+    for (page = 0; page < sizeof(pattern) / AT45_PAGE_SIZE; page++)
+    {
+        if (AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE, (60 + page) * AT45_PAGE_SIZE, false) !=
+            AT45_STATUS_READY)
+            match = false;
+        match &= memcmp(buffer, &pattern[page * AT45_PAGE_SIZE], AT45_PAGE_SIZE) == 0;
+    }
+    TEST_CHECK(match);
+    TEST_CHECK(AT45_Handle.prefetch.hits > 0);
+
+    /* Write drops the read-ahead */
+    AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 61 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY);
+    TEST_CHECK(AT45_Handle.prefetch.count == 0);
+
+    Test_Teardown();
+}
+
+static void Test_Async(void)
+{
+    uint32_t token = 0;
+    AT45_Status_t status;
+
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    TEST_CHECK(AT45_Poll(&AT45_Handle) == AT45_STATUS_READY);
+    TEST_CHECK(AT45_WriteAsync(&AT45_Handle, pattern, AT45_PAGE_SIZE, 70 * AT45_PAGE_SIZE, false, true, &token) ==
+               AT45_STATUS_BUSY_WRITE);
+    TEST_CHECK(token != 0);
+    while ((status = AT45_Poll(&AT45_Handle)) == AT45_STATUS_BUSY_WRITE)
+        Delay(1);
+    TEST_CHECK(status == AT45_STATUS_READY);
+    TEST_CHECK((completedCount == 1) && (completedTokens[0] == token) && (completedResults[0] == AT45_STATUS_READY));
+    TEST_CHECK(memcmp(AT45_Sim0.image->memory[70], pattern, AT45_PAGE_SIZE) == 0);
+
+    /* The next start delivers the previous completion */
+    AT45_WriteAsync(&AT45_Handle, pattern, AT45_PAGE_SIZE, 71 * AT45_PAGE_SIZE, false, true, &token);
+    AT45_WriteAsync(&AT45_Handle, pattern, AT45_PAGE_SIZE, 72 * AT45_PAGE_SIZE, false, true, NULL);
+    TEST_CHECK((completedCount == 2) && (completedTokens[1] == token));
+
+    /* EPE */
+    while (AT45_Poll(&AT45_Handle) == AT45_STATUS_BUSY_WRITE) {}
+    AT45_Sim0.programFault = true;
+    AT45_WriteAsync(&AT45_Handle, pattern, 100, 73 * AT45_PAGE_SIZE, true, true, &token);
+    while ((status = AT45_Poll(&AT45_Handle)) == AT45_STATUS_BUSY_WRITE) {}
+    TEST_CHECK(status == AT45_STATUS_ERROR_PROGRAM);
+    TEST_CHECK((completedCount == 4) && (completedResults[3] == AT45_STATUS_ERROR_PROGRAM));
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 73) && (AT45_Handle.bufferPage[1] != 73));
+
+    /* Waited streams at the maximum tEP: no false timeouts, EPE of the leading page is not masked by later ones */
+    AT45_Sim_SetTiming(&AT45_Sim0, AT45_SIM_TIMING_MAX, TEST_SEED);
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, AT45_PAGE_SIZE * 3, 74 * AT45_PAGE_SIZE, false, true,
+                                AT45_WAIT_BUSY) == AT45_STATUS_READY);
+    AT45_Sim0.programFault = true;
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, AT45_PAGE_SIZE * 3, 74 * AT45_PAGE_SIZE, false, true,
+                                AT45_WAIT_BUSY) == AT45_STATUS_ERROR_PROGRAM);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 74) && (AT45_Handle.bufferPage[1] != 74));
+    AT45_Sim0.programFault = true;
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, AT45_PAGE_SIZE * 3, 74 * AT45_PAGE_SIZE, false, true,
+                                AT45_WAIT_VERIFY) == AT45_STATUS_ERROR_PROGRAM);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 74) && (AT45_Handle.bufferPage[1] != 74));
+
+    Test_Teardown();
+}
+
+static void Test_DMA(void)
+{
+    static uint8_t memory[2 * AT45_PAGE_SIZE];
+    static AT45_CacheSlot_t slots[1];
+    uint32_t page;
+    bool match = true;
+
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    Test_DMAOps = AT45_DMAOps;
+    Test_DMAOps.select = AT45_SimOps.select;
+    Test_DMAOps.deselect = AT45_SimOps.deselect;
+    Test_DMAOps.transfer = Test_DMATransfer;
+    Test_DMAOps.submit = Test_DMASubmit;
+    Test_DMAOps.complete = Test_DMAComplete;
+    AT45_Handle.ops = &Test_DMAOps;
+    idleCount = 0;
+    pendingCount = 0;
+
+    /* Waited transfers complete from the idle hook */
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, sizeof(pattern), 90 * AT45_PAGE_SIZE, false, true,
+                                AT45_WAIT_VERIFY) == AT45_STATUS_READY);
+    TEST_CHECK(idleCount > 0);
+    for (page = 0; page < sizeof(pattern) / AT45_PAGE_SIZE; page++)
+        match &= memcmp(AT45_Sim0.image->memory[90 + page], &pattern[page * AT45_PAGE_SIZE], AT45_PAGE_SIZE) == 0;
+    TEST_CHECK(match);
+
+    /* Submitted read-ahead is still pending at the first completion check */
+    AT45_Erase(&AT45_Handle, AT45_PAGE_ERASE, 0, AT45_WAIT_BUSY);
+    AT45_Handle.bufferPage[0] = AT45_NO_PAGE;
+    AT45_Handle.bufferPage[1] = AT45_NO_PAGE;
+    TEST_CHECK(AT45_PrefetchConfig(&AT45_Handle, memory, 2) == AT45_STATUS_READY);
+    memset(buffer, 0, sizeof(buffer));
+    for (page = 0; page < sizeof(pattern) / AT45_PAGE_SIZE; page++)
+        TEST_CHECK(AT45_Read(&AT45_Handle, &buffer[page * AT45_PAGE_SIZE], AT45_PAGE_SIZE,
+                             (90 + page) * AT45_PAGE_SIZE, false) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, pattern, sizeof(pattern)) == 0);
+    TEST_CHECK(AT45_Handle.prefetch.hits > 0);
+    TEST_CHECK(pendingCount > 0);
+
+    /* The read-ahead in flight is collected before the cache fill */
+    TEST_CHECK(AT45_Handle.prefetch.inFlight && (hspi3.state == SPI_STATE_BUSY_RX));
+    TEST_CHECK(AT45_CacheConfig(&AT45_Handle, slots, 1) == AT45_STATUS_READY);
+    memset(buffer, 0, sizeof(buffer));
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 16, 90 * AT45_PAGE_SIZE + 8, false) == AT45_STATUS_READY);
+    TEST_CHECK(memcmp(buffer, &pattern[8], 16) == 0);
+    TEST_CHECK(hspi3.state == SPI_STATE_READY);
+
+    /* Stalled read-ahead is aborted on timeout and never lands in the slot */
+    AT45_CacheConfig(&AT45_Handle, NULL, 0);
+    AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE, 91 * AT45_PAGE_SIZE, false);
+    AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE, 92 * AT45_PAGE_SIZE, false);
+    TEST_CHECK(AT45_Handle.prefetch.inFlight);
+    dmaStall = true;
+    memset(buffer, 0, sizeof(buffer));
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE, 93 * AT45_PAGE_SIZE, false) == AT45_STATUS_READY);
+    dmaStall = false;
+    TEST_CHECK(memcmp(buffer, &pattern[3 * AT45_PAGE_SIZE], AT45_PAGE_SIZE) == 0);
+    TEST_CHECK(!AT45_Handle.prefetch.inFlight && (AT45_Handle.prefetch.count == 0));
+    TEST_CHECK(hspi3.state == SPI_STATE_READY);
+    memset(memory, 0xA5, sizeof(memory));
+    SPI_IRQHandler(&hspi3);
+    TEST_CHECK((memory[0] == 0xA5) && (memory[AT45_PAGE_SIZE] == 0xA5));
+
+    Test_Teardown();
+}
+
+static void Test_Failures(void)
+{
+    Test_Setup(AT45_SIM_TIMING_TYPICAL);
+
+    /* EPE of the waited program and erase */
+    AT45_Sim0.programFault = true;
+    TEST_CHECK(AT45_Erase(&AT45_Handle, AT45_PAGE_ERASE, 81 * AT45_PAGE_SIZE, AT45_WAIT_BUSY) ==
+               AT45_STATUS_ERROR_PROGRAM);
+    AT45_Sim0.programFault = true;
+    TEST_CHECK(AT45_Write(&AT45_Handle, pattern, AT45_PAGE_SIZE, 80 * AT45_PAGE_SIZE, false, true, AT45_WAIT_BUSY) ==
+               AT45_STATUS_ERROR_PROGRAM);
+
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 80) && (AT45_Handle.bufferPage[1] != 80));
+
+    /* EPE of an intermediate page of the stream, reported as soon as the next page has started */
+    AT45_Sim0.programFault = true;
+    AT45_Sim0.programFaultSkip = 1;
+    TEST_CHECK(AT45_WriteStream(&AT45_Handle, pattern, AT45_PAGE_SIZE * 4, 84 * AT45_PAGE_SIZE, false, true,
+                                AT45_WAIT_BUSY) == AT45_STATUS_ERROR_PROGRAM);
+    TEST_CHECK(!AT45_Sim0.programFault);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 85) && (AT45_Handle.bufferPage[1] != 85));
+
+    /* Bits can't be set without erase: the on-chip compare fails and reads come from the main memory */
+    memset(buffer, 0x0F, AT45_PAGE_SIZE);
+    AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE - 2, 82 * AT45_PAGE_SIZE, true, true, AT45_WAIT_BUSY);
+    memset(buffer, 0xF0, AT45_PAGE_SIZE);
+    TEST_CHECK(AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE - 2, 82 * AT45_PAGE_SIZE, true, false,
+                          AT45_WAIT_VERIFY) == AT45_STATUS_ERROR_VERIFY);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 82) && (AT45_Handle.bufferPage[1] != 82));
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, AT45_PAGE_SIZE - 2, 82 * AT45_PAGE_SIZE, true) ==
+               AT45_STATUS_ERROR_CHECKSUM);
+    TEST_CHECK(buffer[0] == 0x00);
+
+    /* Unverified full page without erase: the buffer is not a copy of the page */
+    memset(buffer, 0xF0, AT45_PAGE_SIZE);
+    TEST_CHECK(AT45_Write(&AT45_Handle, buffer, AT45_PAGE_SIZE, 82 * AT45_PAGE_SIZE, false, false, AT45_WAIT_BUSY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 82) && (AT45_Handle.bufferPage[1] != 82));
+
+    /* Partial frame without erase: the merged buffer holds bits the page can't take */
+    TEST_CHECK(AT45_Write(&AT45_Handle, buffer, 16, 82 * AT45_PAGE_SIZE, false, false, AT45_WAIT_BUSY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK((AT45_Handle.bufferPage[0] != 82) && (AT45_Handle.bufferPage[1] != 82));
+    memset(buffer, 0xFF, AT45_PAGE_SIZE);
+    TEST_CHECK(AT45_Read(&AT45_Handle, buffer, 16, 82 * AT45_PAGE_SIZE, false) == AT45_STATUS_READY);
+    TEST_CHECK((buffer[0] == 0x00) && (buffer[15] == 0x00));
+
+    /* Passing compare: the buffer mirrors the page */
+    memset(buffer, 0x00, AT45_PAGE_SIZE);
+    TEST_CHECK(AT45_Write(&AT45_Handle, buffer, 16, 82 * AT45_PAGE_SIZE, false, false, AT45_WAIT_VERIFY) ==
+               AT45_STATUS_READY);
+    TEST_CHECK((AT45_Handle.bufferPage[0] == 82) || (AT45_Handle.bufferPage[1] == 82));
+
+    /* Nothing to compare with */
+    TEST_CHECK(AT45_Verify(&AT45_Handle, 90 * AT45_PAGE_SIZE) == AT45_STATUS_ERROR_ARGUMENT);
+
+    Test_Teardown();
+}
+
+int main(void)
+{
+    static const TestCase_t cases[] = {{"read_write", Test_ReadWrite}, {"streams", Test_Streams},
+                                       {"read_vector", Test_ReadVector}, {"update", Test_Update},
+                                       {"ping_pong", Test_PingPong}, {"cache", Test_Cache},
+                                       {"prefetch", Test_Prefetch}, {"async", Test_Async}, {"dma", Test_DMA},
+                                       {"failures", Test_Failures}};
+    uint32_t i, failuresBefore;
+
+    for (i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t) (i * 7 + i / 251);
+
+    /* Board wiring, the device itself is powered up for every case */
+    IO_Init(NULL);
+    AT45_Sim_DeInit(&AT45_Sim0);
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        failuresBefore = failures;
+        cases[i].run();
+        printf("%-12s %s\n", cases[i].name, (failures == failuresBefore) ? "ok" : "FAILED");
+    }
+    printf("%u checks, %u failed\n", (unsigned) checks, (unsigned) failures);
+
+    return (failures == 0) ? 0 : 1;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler() has been called \r\n");
+    abort();
+}
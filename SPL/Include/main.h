@@ -2,6 +2,7 @@
 #define MAIN_H
 
 #include "AT45.h"
+#include "benchmark.h"
 #include "init.h"
 #include <stdbool.h>
 
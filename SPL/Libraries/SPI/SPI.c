@@ -1,6 +1,39 @@
 #include "SPI.h"
 
+/* DMA streams assignment (RM0090, DMA1/DMA2 request mapping) */
+typedef struct
+{
+    DMA_Stream_TypeDef *streamRX;
+    DMA_Stream_TypeDef *streamTX;
+    uint32_t channel;
+    uint32_t flagRX_TC;
+    IRQn_Type IRQnRX;
+    uint32_t RCC_AHB1Periph;
+    SPI_HandleTypeDef *hspix;
+} SPI_DMA_LinkTypeDef;
+
+static SPI_DMA_LinkTypeDef SPI_DMA_Link[] = {
+    /* SPI1: RX - DMA2 Stream0, TX - DMA2 Stream3, Channel 3 */
+    {DMA2_Stream0, DMA2_Stream3, DMA_Channel_3, DMA_IT_TCIF0, DMA2_Stream0_IRQn, RCC_AHB1Periph_DMA2, NULL},
+    /* SPI2: RX - DMA1 Stream3, TX - DMA1 Stream4, Channel 0 */
+    {DMA1_Stream3, DMA1_Stream4, DMA_Channel_0, DMA_IT_TCIF3, DMA1_Stream3_IRQn, RCC_AHB1Periph_DMA1, NULL},
+    /* SPI3: RX - DMA1 Stream0, TX - DMA1 Stream5, Channel 0 */
+    {DMA1_Stream0, DMA1_Stream5, DMA_Channel_0, DMA_IT_TCIF0, DMA1_Stream0_IRQn, RCC_AHB1Periph_DMA1, NULL}};
+
 static ErrorStatus SPI_WaitWithTimeout(SPI_HandleTypeDef *hspix, uint32_t timeout, uint32_t tickStart);
+static ErrorStatus SPI_Pipeline(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                uint32_t timeout, uint32_t tickStart);
+static void SPI_FrameSizeConfig(SPI_HandleTypeDef *hspix, bool frame16, uint32_t timeout, uint32_t tickStart);
+static SPI_DMA_LinkTypeDef *SPI_DMA_GetLink(SPI_HandleTypeDef *hspix);
+static SPI_StateTypeDef SPI_DMA_Start(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX,
+                                      uint16_t size);
+static void SPI_DMA_IRQHandler(SPI_DMA_LinkTypeDef *link);
+static SPI_StateTypeDef SPI_IT_Start(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX,
+                                     uint16_t size);
+static void SPI_IRQHandler(SPI_HandleTypeDef *hspix);
+
+/* Handles of the transfers in progress in interrupt mode: SPI1, SPI2, SPI3 */
+static SPI_HandleTypeDef *SPI_IT_Handle[3];
 
 SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t SPI_BaudRatePrescaler)
 {
@@ -11,6 +44,7 @@ SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t
     hspix->countTX = 0;
     hspix->pBuffRX = NULL;
     hspix->pBuffTX = NULL;
+    hspix->frame16 = false;
     hspix->state = SPI_STATE_RESET;
 
     /* Periphery clock enable */
@@ -50,6 +84,33 @@ SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t
     return hspix->state = SPI_STATE_READY;
 }
 
+SPI_StateTypeDef SPI_BaudRateConfig(SPI_HandleTypeDef *hspix, uint16_t SPI_BaudRatePrescaler, uint32_t timeout)
+{
+    uint32_t tickStart = uwTick;
+
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    /* BR may be changed only while there is no communication, BSY bit polling */
+    hspix->state = SPI_STATE_BUSY;
+    if (SPI_WaitWithTimeout(hspix, timeout, tickStart) != SUCCESS)
+        return hspix->state = SPI_STATE_ERROR;
+    CLEAR_BIT(hspix->Instance->CR1, SPI_CR1_SPE);
+    MODIFY_REG(hspix->Instance->CR1, SPI_CR1_BR, SPI_BaudRatePrescaler);
+    SET_BIT(hspix->Instance->CR1, SPI_CR1_SPE);
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+uint32_t SPI_GetBusClock(const SPI_HandleTypeDef *hspix)
+{
+    RCC_ClocksTypeDef RCC_Clocks;
+
+    RCC_GetClocksFreq(&RCC_Clocks);
+
+    return (hspix->Instance == SPI1) ? RCC_Clocks.PCLK2_Frequency : RCC_Clocks.PCLK1_Frequency;
+}
+
 SPI_StateTypeDef SPI_Transmit(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size, uint32_t timeout)
 {
     uint32_t tickStart = uwTick;
@@ -108,6 +169,189 @@ SPI_StateTypeDef SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t
     return hspix->state = SPI_STATE_READY;
 }
 
+SPI_StateTypeDef SPI_TransmitReceive(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                     uint32_t timeout)
+{
+    uint32_t tickStart = uwTick; // One time budget for the whole call
+    uint16_t size16 = 0;
+    ErrorStatus status;
+
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if (size == 0)
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_TX_RX;
+    hspix->pBuffTX = (uint8_t *) pDataTX;
+    hspix->pBuffRX = pDataRX;
+    hspix->sizeTX = size;
+    hspix->sizeRX = size;
+
+    /* Even part as 16-bit frames, the odd byte left as 8-bit frame */
+    if (hspix->frame16 && (size >= 2))
+    {
+        size16 = size & ~1u;
+        SPI_FrameSizeConfig(hspix, true, timeout, tickStart);
+        status = SPI_Pipeline(hspix, pDataTX, pDataRX, size16, timeout, tickStart);
+
+        /* 8-bit frames are restored on failure as well */
+        SPI_FrameSizeConfig(hspix, false, timeout, tickStart);
+        if (status != SUCCESS)
+            return hspix->state = SPI_STATE_ERROR;
+    }
+    if (size16 < size)
+    {
+        if (SPI_Pipeline(hspix, (pDataTX != NULL) ? &pDataTX[size16] : NULL,
+                         (pDataRX != NULL) ? &pDataRX[size16] : NULL, size - size16, timeout,
+                         tickStart) != SUCCESS)
+            return hspix->state = SPI_STATE_ERROR;
+    }
+    hspix->countTX = size;
+    hspix->countRX = size;
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+SPI_StateTypeDef SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size)
+{
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if ((pData == NULL) || (size == 0))
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_TX;
+
+    return SPI_DMA_Start(hspix, pData, NULL, size);
+}
+
+SPI_StateTypeDef SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size)
+{
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if ((pData == NULL) || (size == 0))
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_RX;
+
+    return SPI_DMA_Start(hspix, NULL, pData, size);
+}
+
+SPI_StateTypeDef SPI_Transmit_IT(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size)
+{
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if ((pData == NULL) || (size == 0))
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_TX;
+
+    return SPI_IT_Start(hspix, pData, NULL, size);
+}
+
+SPI_StateTypeDef SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size)
+{
+    if (hspix->state != SPI_STATE_READY)
+        return hspix->state;
+
+    if ((pData == NULL) || (size == 0))
+        return hspix->state = SPI_STATE_ERROR;
+
+    hspix->state = SPI_STATE_BUSY_RX;
+
+    return SPI_IT_Start(hspix, NULL, pData, size);
+}
+
+__weak void SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspix)
+{
+    /* May be redefined in user code */
+    (void) hspix;
+}
+
+SPI_StateTypeDef SPI_Abort(SPI_HandleTypeDef *hspix)
+{
+    SPI_DMA_LinkTypeDef *link = SPI_DMA_GetLink(hspix);
+
+    if ((hspix->state != SPI_STATE_BUSY_TX) && (hspix->state != SPI_STATE_BUSY_RX))
+        return hspix->state;
+    if (link == NULL)
+        return hspix->state = SPI_STATE_ERROR; // No match for SPIx
+
+    /* Requests and interrupts of both modes first, so nothing is stored or signalled afterwards */
+    SPI_I2S_ITConfig(hspix->Instance, SPI_I2S_IT_RXNE, DISABLE);
+    SPI_I2S_DMACmd(hspix->Instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+    SPI_IT_Handle[link - SPI_DMA_Link] = NULL;
+    if (link->hspix == hspix)
+    {
+        DMA_ITConfig(link->streamRX, DMA_IT_TC, DISABLE);
+        DMA_Cmd(link->streamRX, DISABLE);
+        DMA_Cmd(link->streamTX, DISABLE);
+        while (READ_BIT(link->streamRX->CR, DMA_SxCR_EN) || READ_BIT(link->streamTX->CR, DMA_SxCR_EN)) {}
+        DMA_ClearITPendingBit(link->streamRX, link->flagRX_TC);
+    }
+
+    /* Flush the stale RX data and the overrun flag */
+    hspix->Instance->DR;
+    hspix->Instance->SR;
+
+    return hspix->state = SPI_STATE_READY;
+}
+
+void SPIx_IRQHandler(SPI_TypeDef *SPIx)
+{
+    if (SPIx == SPI1)
+        SPI_IRQHandler(SPI_IT_Handle[0]);
+    else if (SPIx == SPI2)
+        SPI_IRQHandler(SPI_IT_Handle[1]);
+    else if (SPIx == SPI3)
+        SPI_IRQHandler(SPI_IT_Handle[2]);
+}
+
+void SPIx_DMA_IRQHandler(SPI_TypeDef *SPIx)
+{
+    if (SPIx == SPI1)
+        SPI_DMA_IRQHandler(&SPI_DMA_Link[0]);
+    else if (SPIx == SPI2)
+        SPI_DMA_IRQHandler(&SPI_DMA_Link[1]);
+    else if (SPIx == SPI3)
+        SPI_DMA_IRQHandler(&SPI_DMA_Link[2]);
+}
+
+#ifdef SPI_USE_IRQ_HANDLERS
+void SPI1_IRQHandler(void)
+{
+    SPI_IRQHandler(SPI_IT_Handle[0]);
+}
+
+void SPI2_IRQHandler(void)
+{
+    SPI_IRQHandler(SPI_IT_Handle[1]);
+}
+
+void SPI3_IRQHandler(void)
+{
+    SPI_IRQHandler(SPI_IT_Handle[2]);
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+    SPI_DMA_IRQHandler(&SPI_DMA_Link[0]);
+}
+
+void DMA1_Stream3_IRQHandler(void)
+{
+    SPI_DMA_IRQHandler(&SPI_DMA_Link[1]);
+}
+
+void DMA1_Stream0_IRQHandler(void)
+{
+    SPI_DMA_IRQHandler(&SPI_DMA_Link[2]);
+}
+#endif
+
 static ErrorStatus SPI_WaitWithTimeout(SPI_HandleTypeDef *hspix, uint32_t timeout, uint32_t tickStart)
 {
     /* Wait for data to be transmitted */
@@ -168,88 +412,227 @@ static ErrorStatus SPI_WaitWithTimeout(SPI_HandleTypeDef *hspix, uint32_t timeou
     return ERROR;
 }
 
-/* Under construction */
-// ErrorStatus SPI_Transmit_IT(SPI_TypeDef *SPIx, const uint8_t *pBuffer, uint32_t lengthTX)
-//{
-//	if (SPIx == SPI1)
-//	{
-//		if (SPI1_Instance.dataTX.status == Idle)
-//		{
-//			SPI1_Instance.dataTX.status = Processing;
-//			SPI1_Instance.dataTX.counter = 0;
-//			SPI1_Instance.dataTX.length = lengthTX;
-//			if (lengthTX <= WriteBufferSize)
-//			{
-//				memcpy(SPI1_Instance.dataTX.data, pBuffer, lengthTX);
-//				SPI_I2S_ITConfig(SPIx, SPI_I2S_IT_TXE, ENABLE);
-//			}
-//			else return ERROR;
-//		}
-//		else
-//		{
-//			if ((SPI1_Instance.dataTX.length + lengthTX) < WriteBufferSize)
-//			{
-//				memcpy((SPI1_Instance.dataTX.data + SPI1_Instance.dataTX.length), pBuffer, lengthTX);
-//				SPI1_Instance.dataTX.length += lengthTX;
-//			}
-//			else return ERROR;
-//		}
-//	}
-//	return SUCCESS;
-// }
-
-// uint32_t SPI_Receive_IT(SPI_TypeDef *SPIx, uint8_t *pBuffer, uint32_t lengthRX)
-//{
-//	if (SPIx == SPI1)
-//	{
-//		if (SPI1_Instance.dataRX.status == Idle)
-//		{
-//			SPI1->DR;
-//			SPI_I2S_ITConfig(SPIx, SPI_I2S_IT_RXNE, ENABLE);
-//			SPI1_Instance.dataRX.status = Processing;
-//			SPI1_Instance.dataRX.pBuffer = pBuffer;
-//			SPI1_Instance.dataRX.length = lengthRX;
-//			SPI1->DR = DontCareByte;
-//		}
-//	}
-//	return 0;
-// }
-
-////#ifdef SPI1_Enable
-// void SPI1_IRQHandler(void)
-//{
-//	if (READ_BIT(SPI1->SR, SPI_SR_TXE))
-//	{
-//		if (SPI1_Instance.dataTX.status == Processing)
-//		{
-//			if (SPI1_Instance.dataTX.counter < SPI1_Instance.dataTX.length)
-//			{
-//				SPI1->DR = SPI1_Instance.dataTX.data[SPI1_Instance.dataTX.counter++];
-//			}
-//			else if (!READ_BIT(SPI1->SR, SPI_SR_BSY))
-//			{
-//				SPI1_Instance.dataTX.status = Idle;
-//				SPI_I2S_ITConfig(SPI1, SPI_I2S_IT_TXE, DISABLE);
-//			}
-//		}
-//	}
-//	if (READ_BIT(SPI1->SR, SPI_SR_RXNE))
-//	{
-//		if (SPI1_Instance.dataRX.status == Processing)
-//		{
-//			SPI1_Instance.dataRX.data[SPI1_Instance.dataRX.counter++] = (uint8_t)SPI1->DR;
-//			if (SPI1_Instance.dataRX.counter < SPI1_Instance.dataRX.length) SPI1->DR = DontCareByte;
-//			else
-//			{
-//				SPI_I2S_ITConfig(SPI1, SPI_I2S_IT_RXNE, DISABLE);
-// #ifndef WipeBufferEachRead
-//				memcpy(SPI1_Instance.dataRX.pBuffer, SPI1_Instance.dataRX.data,
-// SPI1_Instance.dataRX.length); #else 				memcpy(SPI1_Instance.dataRX.pBuffer,
-// SPI1_Instance.dataRX.data,
-// SPI1_Instance.dataRX.counter); #endif 				SPI1_Instance.dataRX.counter = 0;
-// SPI1_Instance.dataRX.status = Idle;
-//			}
-//		}
-//	}
-// }
-////#endif
\ No newline at end of file
+static ErrorStatus SPI_Pipeline(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                uint32_t timeout, uint32_t tickStart)
+{
+    SPI_TypeDef *SPIx = hspix->Instance;
+    uint16_t step = READ_BIT(SPIx->CR1, SPI_CR1_DFF) ? 2 : 1;
+    uint16_t countTX = 0;
+    uint16_t countRX = 0;
+    uint16_t frame;
+
+    /* Flush the stale RX data */
+    SPIx->DR;
+
+    while (countRX < size)
+    {
+        /* Keep up to two frames in flight: one in the shift register and one in DR */
+        if ((countTX < size) && ((countTX - countRX) < (2 * step)) && READ_BIT(SPIx->SR, SPI_SR_TXE))
+        {
+            if (pDataTX == NULL)
+                frame = 0;
+            else if (step == 2)
+                frame = (uint16_t) (pDataTX[countTX] << 8) | pDataTX[countTX + 1];
+            else
+                frame = pDataTX[countTX];
+            SPIx->DR = frame;
+            countTX += step;
+        }
+        else if (READ_BIT(SPIx->SR, SPI_SR_RXNE))
+        {
+            frame = SPIx->DR;
+            if (pDataRX != NULL)
+            {
+                if (step == 2)
+                {
+                    pDataRX[countRX] = (uint8_t) (frame >> 8);
+                    pDataRX[countRX + 1] = (uint8_t) frame;
+                }
+                else
+                    pDataRX[countRX] = (uint8_t) frame;
+            }
+            countRX += step;
+        }
+
+        /* uwTick is read only while the bus stalls, against the tickStart of the whole call */
+        else if ((timeout != INFINITE_TIMEOUT) && ((uwTick - tickStart) >= timeout))
+            return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+static void SPI_FrameSizeConfig(SPI_HandleTypeDef *hspix, bool frame16, uint32_t timeout, uint32_t tickStart)
+{
+    /* DFF may be changed only while the periphery is disabled, a stuck bus is disabled anyway */
+    while (READ_BIT(hspix->Instance->SR, SPI_SR_BSY))
+    {
+        if ((timeout != INFINITE_TIMEOUT) && ((uwTick - tickStart) >= timeout))
+            break;
+    }
+    CLEAR_BIT(hspix->Instance->CR1, SPI_CR1_SPE);
+    if (frame16)
+        SET_BIT(hspix->Instance->CR1, SPI_CR1_DFF);
+    else
+        CLEAR_BIT(hspix->Instance->CR1, SPI_CR1_DFF);
+    SET_BIT(hspix->Instance->CR1, SPI_CR1_SPE);
+}
+
+static SPI_DMA_LinkTypeDef *SPI_DMA_GetLink(SPI_HandleTypeDef *hspix)
+{
+    switch ((uint32_t) hspix->Instance)
+    {
+    case (uint32_t) SPI1:
+        return &SPI_DMA_Link[0];
+
+    case (uint32_t) SPI2:
+        return &SPI_DMA_Link[1];
+
+    case (uint32_t) SPI3:
+        return &SPI_DMA_Link[2];
+
+    default:
+        return NULL; // No match for SPIx
+    }
+}
+
+static SPI_StateTypeDef SPI_DMA_Start(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX,
+                                      uint16_t size)
+{
+    /* Both streams always run: the RX stream completion guarantees that the last byte has left the bus */
+    static uint8_t dummyTX = 0x00;
+    static uint8_t dummyRX;
+    SPI_DMA_LinkTypeDef *link = SPI_DMA_GetLink(hspix);
+    DMA_InitTypeDef DMA_InitStruct;
+
+    if (link == NULL)
+        return hspix->state = SPI_STATE_ERROR;
+
+    link->hspix = hspix;
+    hspix->pBuffTX = (uint8_t *) pDataTX;
+    hspix->pBuffRX = pDataRX;
+    hspix->sizeTX = size;
+    hspix->sizeRX = size;
+    hspix->countTX = 0;
+    hspix->countRX = 0;
+
+    RCC_AHB1PeriphClockCmd(link->RCC_AHB1Periph, ENABLE);
+    DMA_Cmd(link->streamRX, DISABLE);
+    DMA_Cmd(link->streamTX, DISABLE);
+    while (READ_BIT(link->streamRX->CR, DMA_SxCR_EN) || READ_BIT(link->streamTX->CR, DMA_SxCR_EN)) {}
+    DMA_DeInit(link->streamRX);
+    DMA_DeInit(link->streamTX);
+
+    /* Peripheral to memory */
+    DMA_StructInit(&DMA_InitStruct);
+    DMA_InitStruct.DMA_Channel = link->channel;
+    DMA_InitStruct.DMA_PeripheralBaseAddr = (uint32_t) &hspix->Instance->DR;
+    DMA_InitStruct.DMA_Memory0BaseAddr = (uint32_t) ((pDataRX != NULL) ? pDataRX : &dummyRX);
+    DMA_InitStruct.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_InitStruct.DMA_BufferSize = size;
+    DMA_InitStruct.DMA_MemoryInc = (pDataRX != NULL) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStruct.DMA_Priority = DMA_Priority_High;
+    DMA_Init(link->streamRX, &DMA_InitStruct);
+
+    /* Memory to peripheral */
+    DMA_InitStruct.DMA_Memory0BaseAddr = (uint32_t) ((pDataTX != NULL) ? pDataTX : &dummyTX);
+    DMA_InitStruct.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_InitStruct.DMA_MemoryInc = (pDataTX != NULL) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStruct.DMA_Priority = DMA_Priority_Medium;
+    DMA_Init(link->streamTX, &DMA_InitStruct);
+
+    DMA_ITConfig(link->streamRX, DMA_IT_TC, ENABLE);
+    NVIC_EnableIRQ(link->IRQnRX);
+
+    /* Flush the stale RX data and start */
+    hspix->Instance->DR;
+    DMA_Cmd(link->streamRX, ENABLE);
+    DMA_Cmd(link->streamTX, ENABLE);
+    SPI_I2S_DMACmd(hspix->Instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+    return hspix->state;
+}
+
+static void SPI_DMA_IRQHandler(SPI_DMA_LinkTypeDef *link)
+{
+    if (DMA_GetITStatus(link->streamRX, link->flagRX_TC) == RESET)
+        return;
+    DMA_ClearITPendingBit(link->streamRX, link->flagRX_TC);
+
+    SPI_I2S_DMACmd(link->hspix->Instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+    DMA_Cmd(link->streamRX, DISABLE);
+    DMA_Cmd(link->streamTX, DISABLE);
+
+    link->hspix->countTX = link->hspix->sizeTX;
+    link->hspix->countRX = link->hspix->sizeRX;
+    link->hspix->state = SPI_STATE_READY;
+    SPI_TxRxCpltCallback(link->hspix);
+}
+
+static SPI_StateTypeDef SPI_IT_Start(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX,
+                                     uint16_t size)
+{
+    IRQn_Type IRQn;
+
+    switch ((uint32_t) hspix->Instance)
+    {
+    case (uint32_t) SPI1:
+        SPI_IT_Handle[0] = hspix;
+        IRQn = SPI1_IRQn;
+        break;
+
+    case (uint32_t) SPI2:
+        SPI_IT_Handle[1] = hspix;
+        IRQn = SPI2_IRQn;
+        break;
+
+    case (uint32_t) SPI3:
+        SPI_IT_Handle[2] = hspix;
+        IRQn = SPI3_IRQn;
+        break;
+
+    default:
+        return hspix->state = SPI_STATE_ERROR; // No match for SPIx
+    }
+
+    hspix->pBuffTX = (uint8_t *) pDataTX;
+    hspix->pBuffRX = pDataRX;
+    hspix->sizeTX = size;
+    hspix->sizeRX = size;
+    hspix->countTX = 0;
+    hspix->countRX = 0;
+
+    /* Every received frame triggers the next one, so RX can never overrun */
+    hspix->Instance->DR;
+    NVIC_EnableIRQ(IRQn);
+    SPI_I2S_ITConfig(hspix->Instance, SPI_I2S_IT_RXNE, ENABLE);
+    hspix->Instance->DR = (pDataTX != NULL) ? pDataTX[hspix->countTX] : 0;
+    hspix->countTX++;
+
+    return hspix->state;
+}
+
+static void SPI_IRQHandler(SPI_HandleTypeDef *hspix)
+{
+    uint8_t data;
+
+    if ((hspix == NULL) || !READ_BIT(hspix->Instance->SR, SPI_SR_RXNE))
+        return;
+
+    data = hspix->Instance->DR;
+    if (hspix->pBuffRX != NULL)
+        hspix->pBuffRX[hspix->countRX] = data;
+    hspix->countRX++;
+
+    if (hspix->countTX < hspix->sizeTX)
+    {
+        hspix->Instance->DR = (hspix->pBuffTX != NULL) ? hspix->pBuffTX[hspix->countTX] : 0;
+        hspix->countTX++;
+    }
+    else
+    {
+        SPI_I2S_ITConfig(hspix->Instance, SPI_I2S_IT_RXNE, DISABLE);
+        hspix->state = SPI_STATE_READY;
+        SPI_TxRxCpltCallback(hspix);
+    }
+}
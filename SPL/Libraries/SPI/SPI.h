@@ -2,10 +2,15 @@
 #define SPI_H
 
 #include "Delay.h"
+#include <stdbool.h>
 #include <stdlib.h>
 
 #define INFINITE_TIMEOUT 0
 
+/* Defines SPI1-3_IRQHandler() and the handlers of their DMA RX streams (DMA2 Stream0, DMA1 Stream3, DMA1 Stream0).
+   Comment out if the application owns these vectors, it has to call SPIx_IRQHandler()/SPIx_DMA_IRQHandler() then */
+#define SPI_USE_IRQ_HANDLERS
+
 typedef enum {
     SPI_STATE_RESET = 0x00U, // Peripheral not Initialized
     SPI_STATE_READY = 0x01U, // Peripheral Initialized and ready for use
@@ -26,6 +31,7 @@ typedef struct
     uint16_t countTX;
     uint8_t *pBuffRX;
     uint8_t *pBuffTX;
+    bool frame16; // Clock even parts of SPI_TransmitReceive() blocks as 16-bit frames
     SPI_StateTypeDef state;
 } SPI_HandleTypeDef;
 
@@ -38,6 +44,22 @@ typedef struct
  */
 SPI_StateTypeDef SPIx_Init(SPI_HandleTypeDef *hspix, uint16_t SPI_Mode, uint16_t SPI_BaudRatePrescaler);
 
+/**
+ * @brief Changes the baud rate of initialized SPI
+ * @param hspix: pointer to target SPI handle
+ * @param SPI_BaudRatePrescaler: SPI_BaudRatePrescaler_2...4,8,16,32,64,128,256
+ * @param timeout: timeout duration of the wait for the end of communication
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_BaudRateConfig(SPI_HandleTypeDef *hspix, uint16_t SPI_BaudRatePrescaler, uint32_t timeout);
+
+/**
+ * @brief Gets the clock of the bus, SPI is connected to
+ * @param hspix: pointer to target SPI handle
+ * @return PCLK2 for SPI1, PCLK1 for SPI2 and SPI3 [Hz]
+ */
+uint32_t SPI_GetBusClock(const SPI_HandleTypeDef *hspix);
+
 /**
  * @brief Transmit an amount of data in blocking mode
  * @param hspix: pointer to target SPI handle
@@ -58,4 +80,83 @@ SPI_StateTypeDef SPI_Transmit(SPI_HandleTypeDef *hspix, const uint8_t *pData, ui
  */
 SPI_StateTypeDef SPI_Receive(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size, uint32_t timeout);
 
+/**
+ * @brief Transmit and receive an amount of data in blocking mode with continuously fed shift register
+ * @param hspix: pointer to target SPI handle
+ * @param pDataTX: pointer to data source buffer, NULL - dummy bytes are transmitted
+ * @param pDataRX: pointer to data destination buffer, NULL - received data is discarded
+ * @param size: number of bytes to transfer
+ * @param timeout: timeout duration of the whole block
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_TransmitReceive(SPI_HandleTypeDef *hspix, const uint8_t *pDataTX, uint8_t *pDataRX, uint16_t size,
+                                     uint32_t timeout);
+
+/**
+ * @brief Transmit an amount of data in non-blocking mode with DMA
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @return SPI status after current operation
+ * @note SPI_TxRxCpltCallback() is called when the last byte has left the shift register
+ */
+SPI_StateTypeDef SPI_Transmit_DMA(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Receive an amount of data in non-blocking mode with DMA
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @return SPI status after current operation
+ * @note SPI_TxRxCpltCallback() is called when the last byte has been stored
+ */
+SPI_StateTypeDef SPI_Receive_DMA(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Transmit an amount of data in non-blocking mode with interrupt
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data source buffer
+ * @param size: number of bytes to transmit
+ * @return SPI status after current operation
+ * @note SPI_TxRxCpltCallback() is called when the last byte has left the shift register
+ */
+SPI_StateTypeDef SPI_Transmit_IT(SPI_HandleTypeDef *hspix, const uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Receive an amount of data in non-blocking mode with interrupt
+ * @param hspix: pointer to target SPI handle
+ * @param pData: pointer to data destination buffer
+ * @param size: number of bytes to receive
+ * @return SPI status after current operation
+ * @note SPI_TxRxCpltCallback() is called when the last byte has been stored
+ */
+SPI_StateTypeDef SPI_Receive_IT(SPI_HandleTypeDef *hspix, uint8_t *pData, uint16_t size);
+
+/**
+ * @brief Stops the DMA or interrupt transfer in progress, SPI_TxRxCpltCallback() is not called for it
+ * @param hspix: pointer to target SPI handle
+ * @return SPI status after current operation
+ */
+SPI_StateTypeDef SPI_Abort(SPI_HandleTypeDef *hspix);
+
+/**
+ * @brief Services the SPI interrupt of the transfer started by SPI_Transmit_IT()/SPI_Receive_IT()
+ * @param SPIx: SPI1, SPI2 or SPI3
+ * @note Called by SPI1-3_IRQHandler() with SPI_USE_IRQ_HANDLERS
+ */
+void SPIx_IRQHandler(SPI_TypeDef *SPIx);
+
+/**
+ * @brief Services the DMA RX stream interrupt of the transfer started by SPI_Transmit_DMA()/SPI_Receive_DMA()
+ * @param SPIx: SPI1, SPI2 or SPI3
+ * @note Called by DMA2_Stream0/DMA1_Stream3/DMA1_Stream0_IRQHandler() with SPI_USE_IRQ_HANDLERS
+ */
+void SPIx_DMA_IRQHandler(SPI_TypeDef *SPIx);
+
+/**
+ * @brief Transfer completed callback, called from the SPI or DMA interrupt
+ * @param hspix: pointer to target SPI handle
+ */
+void SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspix);
+
 #endif
\ No newline at end of file
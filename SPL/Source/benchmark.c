@@ -0,0 +1,171 @@
+#include "benchmark.h"
+
+#ifdef AT45_BENCHMARK
+
+/* Public variables */
+BenchmarkTable_t benchmarkTable;
+
+/* Private variables */
+static const uint16_t prescalers[BENCHMARK_PRESCALERS] = {
+    SPI_BaudRatePrescaler_2,  SPI_BaudRatePrescaler_4,  SPI_BaudRatePrescaler_8,   SPI_BaudRatePrescaler_16,
+    SPI_BaudRatePrescaler_32, SPI_BaudRatePrescaler_64, SPI_BaudRatePrescaler_128, SPI_BaudRatePrescaler_256};
+static uint8_t bufferWrite[BENCHMARK_DATA_LENGTH];
+static uint8_t bufferRead[AT45_PAGE_SIZE];
+static uint32_t cycleStart;
+static uint32_t tickStart;
+
+/* Private function prototypes */
+static uint32_t Benchmark_SetPrescaler(SPI_HandleTypeDef *hspix, uint16_t prescaler);
+static void Benchmark_Start(void);
+static uint64_t Benchmark_Stop(void);
+static void Benchmark_Record(BenchmarkResult_t *result, uint64_t cycles, AT45_Status_t status);
+static void Benchmark_WaitReady(AT45_HandleTypeDef *AT45_Handle);
+
+void Benchmark_Run(AT45_HandleTypeDef *AT45_Handle, SPI_HandleTypeDef *hspix, GPIO_TypeDef *CS_Port,
+                   uint16_t CS_Pin)
+{
+    static const AT45_WaitForTask_t waits[] = {AT45_WAIT_NO, AT45_WAIT_DELAY, AT45_WAIT_BUSY};
+    static const AT45_EraseInstruction_t erases[] = {AT45_PAGE_ERASE, AT45_BLOCK_ERASE, AT45_SECTOR_ERASE};
+    static const uint32_t eraseSizes[] = {AT45_PAGE_SIZE, AT45_BLOCK_SIZE, AT45_SECTOR_SIZE};
+    const uint32_t firstAddress = BENCHMARK_FIRST_PAGE * AT45_PAGE_SIZE;
+    BenchmarkResult_t *results;
+    AT45_Status_t status;
+    uint64_t cycles;
+    uint32_t i, p, w, e, op;
+
+    /* DWT cycle counter */
+    SET_BIT(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+    DWT->CYCCNT = 0;
+    SET_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);
+
+    memset(&benchmarkTable, 0, sizeof(benchmarkTable));
+    benchmarkTable.coreClock = SystemCoreClock;
+    for (i = 0; i < sizeof(bufferWrite); i++)
+        bufferWrite[i] = (uint8_t) i;
+
+    for (p = 0; p < BENCHMARK_PRESCALERS; p++)
+    {
+        benchmarkTable.sckClock[p] = Benchmark_SetPrescaler(hspix, prescalers[p]);
+        results = benchmarkTable.results[p];
+        for (op = 0; op < BENCHMARK_OPERATIONS; op++)
+            results[op].min = UINT64_MAX;
+
+        /* Init */
+        for (i = 0; i < BENCHMARK_REPETITIONS; i++)
+        {
+            Benchmark_Start();
+            status = AT45_Init(AT45_Handle, hspix, CS_Port, CS_Pin);
+            Benchmark_Record(&results[BENCHMARK_INIT], Benchmark_Stop(), status);
+        }
+        if (AT45_Handle->status != AT45_STATUS_READY)
+            break;
+
+        /* Write in every wait mode, the previous operation is completed beforehand */
+        for (w = 0; w < sizeof(waits) / sizeof(waits[0]); w++)
+        {
+            for (i = 0; i < BENCHMARK_REPETITIONS; i++)
+            {
+                Benchmark_WaitReady(AT45_Handle);
+                Benchmark_Start();
+                status = AT45_Write(AT45_Handle, bufferWrite, sizeof(bufferWrite),
+                                    firstAddress + (i * AT45_PAGE_SIZE), true, true, waits[w]);
+                Benchmark_Record(&results[BENCHMARK_WRITE_NO + w], Benchmark_Stop(), status);
+            }
+        }
+        Benchmark_WaitReady(AT45_Handle);
+
+        /* Read back the pages written above */
+        for (i = 0; i < BENCHMARK_REPETITIONS; i++)
+        {
+            Benchmark_Start();
+            status = AT45_Read(AT45_Handle, bufferRead, sizeof(bufferWrite), firstAddress + (i * AT45_PAGE_SIZE),
+                               true);
+            cycles = Benchmark_Stop();
+            if (memcmp(bufferRead, bufferWrite, sizeof(bufferWrite)) != 0)
+                status = AT45_STATUS_ERROR_CHECKSUM;
+            Benchmark_Record(&results[BENCHMARK_READ_CRC], cycles, status);
+
+            Benchmark_Start();
+            status = AT45_Read(AT45_Handle, bufferRead, sizeof(bufferRead), firstAddress + (i * AT45_PAGE_SIZE),
+                               false);
+            Benchmark_Record(&results[BENCHMARK_READ], Benchmark_Stop(), status);
+        }
+
+        /* Erase within sector 15 */
+        for (e = 0; e < sizeof(erases) / sizeof(erases[0]); e++)
+        {
+            for (i = 0; i < BENCHMARK_REPETITIONS; i++)
+            {
+                Benchmark_Start();
+                status = AT45_Erase(AT45_Handle, erases[e], firstAddress + ((i * eraseSizes[e]) % AT45_SECTOR_SIZE),
+                                    AT45_WAIT_BUSY);
+                Benchmark_Record(&results[BENCHMARK_PAGE_ERASE + e], Benchmark_Stop(), status);
+            }
+        }
+#if BENCHMARK_USE_CHIP_ERASE
+        Benchmark_Start();
+        status = AT45_Erase(AT45_Handle, AT45_CHIP_ERASE, 0, AT45_WAIT_BUSY);
+        Benchmark_Record(&results[BENCHMARK_CHIP_ERASE], Benchmark_Stop(), status);
+#endif
+
+        for (op = 0; op < BENCHMARK_OPERATIONS; op++)
+        {
+            if (results[op].count != 0)
+                results[op].avg /= results[op].count;
+            else
+                results[op].min = 0;
+        }
+    }
+
+    benchmarkTable.done = true;
+}
+
+/**
+ * @section Private functions
+ */
+static uint32_t Benchmark_SetPrescaler(SPI_HandleTypeDef *hspix, uint16_t prescaler)
+{
+    RCC_ClocksTypeDef RCC_Clocks;
+
+    if (SPIx_Init(hspix, SPI_Mode_Master, prescaler) != SPI_STATE_READY)
+        Error_Handler();
+
+    RCC_GetClocksFreq(&RCC_Clocks);
+
+    return ((hspix->Instance == SPI1) ? RCC_Clocks.PCLK2_Frequency : RCC_Clocks.PCLK1_Frequency) >>
+           ((prescaler >> 3) + 1);
+}
+
+static void Benchmark_Start(void)
+{
+    tickStart = AT45_GetTick();
+    cycleStart = DWT->CYCCNT;
+}
+
+static uint64_t Benchmark_Stop(void)
+{
+    uint32_t cycles = DWT->CYCCNT - cycleStart;
+    int64_t estimate = (int64_t) (AT45_GetTick() - tickStart) * (SystemCoreClock / 1000);
+
+    /* CYCCNT wraps every 25.6 s at 168 MHz, the tick count resolves the number of wraps */
+    return ((uint64_t) ((estimate - cycles + (1LL << 31)) >> 32) << 32) + cycles;
+}
+
+static void Benchmark_Record(BenchmarkResult_t *result, uint64_t cycles, AT45_Status_t status)
+{
+    if (status != AT45_STATUS_READY)
+        result->errors++;
+    if (cycles < result->min)
+        result->min = cycles;
+    if (cycles > result->max)
+        result->max = cycles;
+    result->avg += cycles; // Sum until the end of the sweep
+    result->count++;
+}
+
+static void Benchmark_WaitReady(AT45_HandleTypeDef *AT45_Handle)
+{
+    while (AT45_Busy(AT45_Handle)) {}
+}
+
+#endif
@@ -10,6 +10,9 @@ void main(void)
     Sys_Init();
     IO_Init();
     SPIx_Init(&hspi3, SPI_Mode_Master, SPI_BaudRatePrescaler_256);
+#ifdef AT45_BENCHMARK
+    Benchmark_Run(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin);
+#else
     AT45_Init(&AT45_Handle, &hspi3, CS0_GPIO_Port, CS0_Pin);
     if (AT45_Handle.status == AT45_STATUS_READY)
     {
@@ -24,10 +27,9 @@ void main(void)
         {
             printf("Data doesn't exist at page %i boundaries \r\n", PAGE);
             printf("Page programming...");
-            AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), PAGE_ADDRESS, true, true, AT45_WAIT_BUSY);
-            printf("\r\n Second approach to read \r\n");
-            AT45_Read(&AT45_Handle, bufferRead, sizeof(bufferRead), PAGE_ADDRESS, true);
-            if (strncmp((const char *) bufferRead, (const char *) bufferWrite, sizeof(bufferRead)) == 0)
+            AT45_Write(&AT45_Handle, bufferWrite, sizeof(bufferWrite), PAGE_ADDRESS, true, true, AT45_WAIT_VERIFY);
+            printf("\r\n On-chip verify \r\n");
+            if (AT45_Handle.status == AT45_STATUS_READY)
             {
                 printf("Writing process success \r\n");
             }
@@ -43,6 +45,7 @@ void main(void)
         printf("Couldn't get any response from device \r\n");
         Error_Handler();
     }
+#endif
 
     while (true) {}
 }